@@ -0,0 +1,31 @@
+#pragma once
+
+#include <evm_runtime/types.hpp>
+#include <silkworm/core/common/base.hpp>
+
+namespace evm_runtime {
+
+using silkworm::ByteView;
+
+// Bump when the layout of code_analysis::jumpdests changes; rows with another version are ignored.
+static constexpr uint32_t code_analysis_version = 1;
+
+struct code_analysis {
+    uint32_t version = 0;
+    bytes    jumpdests; // bit i (LSB first in each byte) is set if code[i] is a valid JUMPDEST
+
+    bool is_valid_for(ByteView code) const {
+        return version == code_analysis_version && jumpdests.size() == (code.size() + 7) / 8;
+    }
+
+    EOSLIB_SERIALIZE(code_analysis, (version)(jumpdests));
+};
+
+code_analysis analyze_code(ByteView code);
+
+// Makes evmone use `jumpdests` instead of analyzing `code` again. The caller keeps both
+// buffers alive until the matching unregister_code_analysis.
+void register_code_analysis(ByteView code, const bytes& jumpdests);
+void unregister_code_analysis(ByteView code);
+
+} // namespace evm_runtime
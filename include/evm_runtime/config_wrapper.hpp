@@ -57,6 +57,13 @@ struct config_wrapper {
     eosio::symbol get_token_symbol() const;
     uint64_t get_minimum_natively_representable() const;
 
+    uint32_t get_gc_budget() const;
+    uint32_t get_max_inline_erase_slots() const;
+    void set_gc_parameters(uint32_t gc_budget, uint32_t max_inline_erase_slots);
+
+    uint32_t get_event_flags() const;
+    void set_event_flags(uint32_t event_flags);
+
 private:
     bool is_dirty()const;
     void set_dirty();
@@ -64,12 +71,17 @@ private:
 
     eosio::time_point get_current_time()const;
 
+    config& cached()const;
+    void set_next_price_block(uint64_t block_num);
+    void load_next_price_block();
+
     bool _dirty  = false;
-    bool _exists = false;
-    config _cached_config;
+    mutable bool _loaded = false;
+    mutable bool _exists = false;
+    mutable config _cached_config;
 
     eosio::name _self;
-    eosio::singleton<"config"_n, config> _config;
+    mutable eosio::singleton<"config"_n, config> _config;
     mutable std::optional<eosio::time_point> current_time_point;
 };
 
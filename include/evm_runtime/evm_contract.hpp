@@ -12,6 +12,7 @@
 
 #ifdef WITH_TEST_ACTIONS
 #include <evm_runtime/test/block_info.hpp>
+#include <evm_runtime/state.hpp>
 #endif
 
 using namespace eosio;
@@ -62,6 +63,14 @@ public:
 
    [[eosio::action]] void pushtx(eosio::name miner, bytes rlptx, eosio::binary_extension<uint64_t> min_inclusion_price);
 
+   /**
+    * @brief Execute a batch of EVM transactions in the same EVM block context
+    *
+    * The transactions are executed in order against a single state and execution processor. Miner fees and
+    * inevm changes are settled once for the whole batch and a single evmtx event is emitted.
+    */
+   [[eosio::action]] void pushtxs(eosio::name miner, std::vector<bytes> rlptxs, eosio::binary_extension<uint64_t> min_inclusion_price);
+
    [[eosio::action]] void open(eosio::name owner);
 
    [[eosio::action]] void close(eosio::name owner);
@@ -71,8 +80,67 @@ public:
 
    [[eosio::action]] void withdraw(eosio::name owner, eosio::asset quantity, const eosio::binary_extension<eosio::name> &to);
 
-   /// @return true if all garbage has been collected
-   [[eosio::action]] bool gc(uint32_t max);
+   /**
+    * @brief Erase up to `max` rows of the storage of removed accounts
+    *
+    * Each call starts with the entry after the one the previous call stopped in, so a large
+    * storage does not hold back the entries queued after it.
+    */
+   [[eosio::action]] gc_result gc(uint32_t max);
+
+   /**
+    * @brief List up to `max_entries` pending `gc` entries in the order they will be visited
+    *
+    * The rows of each entry are counted up to `max_rows`.
+    */
+   [[eosio::action, eosio::read_only]] gc_backlog gcbacklog(uint32_t max_entries, uint32_t max_rows);
+
+   /**
+    * @brief Count up to `max` entries of a `gcstore` backlog left by an older contract
+    *
+    * Until the backlog is counted, the backlog reported by `gc` and `gcbacklog` leaves those
+    * entries out. Each call resumes where the previous one stopped.
+    *
+    * @return true if all entries are counted
+    */
+   [[eosio::action]] bool countgc(uint32_t max);
+
+   /**
+    * @brief Move up to `max` rows of the legacy `accountcode` table into `codemeta`/`codeblob`
+    *
+    * Rows are also migrated on demand when their code is deployed again or released.
+    *
+    * @return true if all legacy rows have been migrated
+    */
+   [[eosio::action]] bool migratecode(uint32_t max);
+
+   /**
+    * @brief Move slots of the legacy `storage` table into `storage2`, compacting their keys and values
+    *
+    * Each visited account and each moved slot count against `max`, the next call resumes where
+    * this one stopped. Slots are also migrated on demand when they are written.
+    *
+    * @return true if the storage of all accounts has been migrated
+    */
+   [[eosio::action]] bool migratestor(uint32_t max);
+
+   /**
+    * @brief Move up to `max` rows of the legacy `account` table into `account2`
+    *
+    * Accounts are also migrated on demand when they are written.
+    *
+    * @return true if all legacy accounts have been migrated
+    */
+   [[eosio::action]] bool migrateacct(uint32_t max);
+
+   /**
+    * @brief Merge up to `max` owners of the legacy `balances` and `nextnonces` tables into `vaults`
+    *
+    * Owners are also migrated on demand when their vault is looked up.
+    *
+    * @return true if all legacy rows have been migrated
+    */
+   [[eosio::action]] bool migratevault(uint32_t max);
 
    
    [[eosio::action]] void call(eosio::name from, const bytes& to, const bytes& value, const bytes& data, uint64_t gas_limit);
@@ -88,11 +156,35 @@ public:
    [[eosio::action]] void updtgasparam(eosio::asset ram_price_mb, uint64_t gas_price);
    [[eosio::action]] void setgasparam(uint64_t gas_txnewaccount, uint64_t gas_newaccount, uint64_t gas_txcreate, uint64_t gas_codedeposit, uint64_t gas_sset);
 
+   /**
+    * @brief Set how many rows of pending `gc` work each `pushtx`, `pushtxs`, `call` and EVM deposit does
+    *
+    * Zero leaves garbage collection to the `gc` action alone. The storage of a removed account with
+    * at most `max_inline_slots` slots is erased right away instead of being queued, zero disables it.
+    */
+   [[eosio::action]] void setgcbudget(uint32_t max, uint32_t max_inline_slots);
+
+   /**
+    * @brief Select the optional events the contract sends, see event_flags
+    *
+    * With compact_evmtx set, evmtx carries an evmtx_v1 that leaves out the rlp of transactions
+    * already present in the pushtx or pushtxs action data. With state_diff set, each action that
+    * sends evmtx also sends statediff, so EVM nodes can follow the state without re-executing.
+    */
+   [[eosio::action]] void setevents(uint32_t flags);
+
+   /// @return storage slots and bytes held by the account, unset if they are not known
+   [[eosio::action, eosio::read_only]] std::optional<storage_usage> storageusage(const bytes& address);
+
    // Events
    [[eosio::action]] void evmtx(eosio::ignore<evm_runtime::evmtx_type> event){
       eosio::check(get_sender() == get_self(), "forbidden to call");
    };
 
+   [[eosio::action]] void statediff(eosio::ignore<evm_runtime::statediff_type> event){
+      eosio::check(get_sender() == get_self(), "forbidden to call");
+   };
+
    // Events
    [[eosio::action]] void configchange(consensus_parameter_data_type consensus_parameter_data) {
       eosio::check(get_sender() == get_self(), "forbidden to call");
@@ -120,21 +212,43 @@ public:
    [[eosio::action]] void dumpall();
    [[eosio::action]] void setbal(const bytes& addy, const bytes& bal);
    [[eosio::action]] void testbaldust(const name test);
+#ifdef WITH_K1_RECOVER
+   [[eosio::action]] void testrecover(const bytes& rlptx, const bytes& sender);
+#endif
+   [[eosio::action]] evm_runtime::db_stats teststate(const bytes& addy, const std::vector<bytes>& locations, const bytes& value, bool warm);
+   [[eosio::action]] void testmixedtx(eosio::name miner, std::vector<bytes> rlptxs);
+   [[eosio::action]] void testrlpmove(const bytes& rlptx);
 #endif
 
 private:
    void open_internal_balance(eosio::name owner);
    std::shared_ptr<struct config_wrapper> _config;
+   std::shared_ptr<struct vault_wrapper> _vaults;
 
    enum class status_flags : uint32_t
    {
       frozen = 0x1
    };
 
+   enum class event_flags : uint32_t
+   {
+      compact_evmtx = 0x1,
+      state_diff    = 0x2
+   };
+
    void assert_inited();
    void assert_unfrozen();
 
-   silkworm::Receipt execute_tx(const runtime_config& rc, eosio::name miner, silkworm::Block& block, const transaction& tx, silkworm::ExecutionProcessor& ep);
+   // Balance changes accumulated while executing the transactions of a batch, applied once by settle_txs.
+   struct tx_accumulator {
+      intx::uint256 miner_fee;
+      intx::uint256 inevm_credit;
+      intx::uint256 inevm_debit;
+      uint64_t      cumulative_gas_used = 0;
+   };
+
+   silkworm::Receipt execute_tx(const runtime_config& rc, eosio::name miner, silkworm::Block& block, const transaction& tx, silkworm::ExecutionProcessor& ep, tx_accumulator& acc);
+   void settle_txs(eosio::name miner, const tx_accumulator& acc);
    void process_filtered_messages(const std::vector<silkworm::FilteredMessage>& filtered_messages);
 
    uint64_t get_and_increment_nonce(const name owner);
@@ -148,8 +262,8 @@ private:
 
    using pushtx_action = eosio::action_wrapper<"pushtx"_n, &evm_contract::pushtx>;
 
-   void process_tx(const runtime_config& rc, eosio::name miner, const transaction& tx, std::optional<uint64_t> min_inclusion_price);
-   void dispatch_tx(const runtime_config& rc, const transaction& tx);
+   void process_txs(const runtime_config& rc, eosio::name miner, std::vector<transaction>& txs, std::optional<uint64_t> min_inclusion_price);
+   void dispatch_tx(const runtime_config& rc, transaction tx);
 };
 
 } // namespace evm_runtime
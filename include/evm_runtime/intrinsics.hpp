@@ -5,6 +5,28 @@ namespace eosio {
          __attribute__((eosio_wasm_import))
          uint32_t get_code_hash(uint64_t account, uint32_t struct_version, char* data, uint32_t size);
 
+         __attribute__((eosio_wasm_import))
+         int32_t k1_recover(const char* sig, uint32_t sig_len, const char* dig, uint32_t dig_len, char* pub, uint32_t pub_len);
+
+         __attribute__((eosio_wasm_import))
+         void sha3(const char* data, uint32_t data_len, char* hash, uint32_t hash_len, int32_t keccak);
+
+         __attribute__((eosio_wasm_import))
+         int32_t alt_bn128_add(const char* op1, uint32_t op1_len, const char* op2, uint32_t op2_len, char* result, uint32_t result_len);
+
+         __attribute__((eosio_wasm_import))
+         int32_t alt_bn128_mul(const char* g1, uint32_t g1_len, const char* scalar, uint32_t scalar_len, char* result, uint32_t result_len);
+
+         __attribute__((eosio_wasm_import))
+         int32_t alt_bn128_pair(const char* pairs, uint32_t pairs_len);
+
+         __attribute__((eosio_wasm_import))
+         int32_t mod_exp(const char* base, uint32_t base_len, const char* exp, uint32_t exp_len, const char* mod, uint32_t mod_len, char* result, uint32_t result_len);
+
+         __attribute__((eosio_wasm_import))
+         int32_t blake2_f(uint32_t rounds, const char* state, uint32_t state_len, const char* msg, uint32_t msg_len,
+                          const char* t0_offset, uint32_t t0_len, const char* t1_offset, uint32_t t1_len, int32_t final, char* result, uint32_t result_len);
+
         #ifdef WITH_LOGTIME
         __attribute__((eosio_wasm_import))
          void logtime(const char*);
@@ -2,9 +2,13 @@
 
 #include <vector>
 #include <map>
+#include <set>
+#include <tuple>
 #include <eosio/eosio.hpp>
 #include <evm_runtime/types.hpp>
+#include <evm_runtime/tables.hpp>
 #include <silkworm/core/state/state.hpp>
+#include <silkworm/core/types/transaction.hpp>
 
 namespace evm_runtime {
 
@@ -16,11 +20,19 @@ struct table_stats {
     uint32_t update=0;
     uint32_t create=0;
     uint32_t remove=0;
+    uint32_t cached=0;  // lookups answered without touching the table
+    uint32_t absent=0;  // lookups answered by the cache of missing rows
+    uint32_t missing=0; // lookups that found no row and were added to that cache
+
+    EOSLIB_SERIALIZE(table_stats, (read)(update)(create)(remove)(cached)(absent)(missing));
 };
 
 struct db_stats {
     table_stats account;
     table_stats storage;
+    uint32_t coalesced=0; // storage writes merged into an already buffered one
+
+    EOSLIB_SERIALIZE(db_stats, (account)(storage)(coalesced));
 };
 
 struct state : State {
@@ -28,15 +40,21 @@ struct state : State {
     name _ram_payer;
     bool _read_only;
     bool _allow_frozen;
+    uint32_t _max_inline_erase_slots = 0; // storage of removed accounts up to this size skips `gc`, 0 disables
     mutable std::map<evmc::address, uint64_t> addr2id;
     mutable std::map<bytes32, bytes> addr2code;
+    mutable std::map<bytes32, bytes> code2jumpdests;
+    mutable std::map<uint64_t, bool> legacy_storage;
+    mutable std::optional<bool> legacy_accounts;
     mutable db_stats stats;
     std::optional<config2> _config2;
+    std::optional<statediff_v0> changes; // <- when set, collects the changes written to the tables
 
     explicit state(name self, name ram_payer, bool read_only=false, bool allow_frozen=true) : _self(self), _ram_payer(ram_payer), _read_only{read_only}, _allow_frozen{allow_frozen}{}
     virtual ~state() override;
 
     uint64_t get_next_account_id();
+    config2& load_config2();
 
     std::optional<Account> read_account(const evmc::address& address) const noexcept override;
 
@@ -75,8 +93,55 @@ struct state : State {
     void update_account(const evmc::address& address, std::optional<Account> initial,
                         std::optional<Account> current) override;
 
-    /// @return true if all garbage has been collected
-    bool gc(uint32_t max);
+    /// Erases up to `max` rows, starting with the entry after the one the previous call stopped in
+    gc_result gc(uint32_t max);
+
+    /// Lists up to `max_entries` entries in the order `gc` visits them, counting up to `max_rows` rows of each
+    gc_backlog inspect_gc(uint32_t max_entries, uint32_t max_rows) const;
+
+    /// Drops the entry without collecting its storage
+    void remove_gc_entry(uint64_t id);
+
+    /// Counts up to `max` entries of a backlog queued before `gcprogress` existed
+    /// @return true if all entries are counted
+    bool count_gc(uint32_t max);
+
+    /// @return true if all legacy account codes have been migrated
+    bool migrate_code(uint32_t max);
+
+    /// Drops a reference to the code, removing it when no account uses it anymore
+    void release_code(uint64_t code_id);
+
+    /// @return true if the legacy storage of all accounts has been migrated
+    bool migrate_storage(uint32_t max);
+
+    /// @return true if all legacy accounts have been migrated
+    bool migrate_accounts(uint32_t max);
+
+    /// Moves the legacy row of the account, if any, to `account2`
+    void migrate_account(uint64_t id);
+
+    /// Erases the account, queueing its storage for garbage collection unless it is small enough to erase now
+    void remove_account(account2_table::const_iterator itr);
+
+    account2_table& accounts() const;
+    storage2_table& storage2(uint64_t account_id) const;
+
+    evmc::bytes32 read_slot(uint64_t account_id, const evmc::bytes32& location) const;
+
+    /// Looks up the accounts and slots of an access list ahead of execution, so that the reads
+    /// and writes of the transaction find them in the caches
+    void warm_up(const std::vector<AccessListEntry>& access_list) const;
+
+    /// Writing a zero value removes the slot
+    void write_slot(uint64_t account_id, const evmc::bytes32& location, const evmc::bytes32& value);
+
+    /// Applies the storage writes buffered by update_storage, scope by scope in row order, and
+    /// the resulting storage usage of each account
+    void flush();
+
+    /// @return storage usage of the account, unset if it is not known
+    std::optional<storage_usage> read_storage_usage(const evmc::address& address) const;
 
     void update_account_code(const evmc::address& address, uint64_t incarnation, const evmc::bytes32& code_hash,
                              ByteView code) override;
@@ -85,6 +150,59 @@ struct state : State {
                         const evmc::bytes32& initial, const evmc::bytes32& current) override;
 
     void unwind_state_changes(uint64_t block_number) override;
+
+private:
+    struct account_probe {
+        account2_table::const_iterator row; // row of the address, end() if not found
+        uint64_t                        key; // key holding the address or free to take it
+    };
+
+    struct slot_probe {
+        storage2_table::const_iterator row;  // row holding the slot, end() if not stored
+        uint64_t                       free; // first id of the probe chain that can take the slot
+    };
+
+    // Table handles live as long as the state, so rows read once stay in their item cache and
+    // probes resolved by a read are reused by the write that follows it
+    mutable std::optional<account2_table> _accounts;
+    mutable std::map<uint64_t, storage2_table> _storages;
+    mutable std::map<evmc::address, account_probe> addr2probe;
+    mutable std::map<std::pair<uint64_t, evmc::bytes32>, slot_probe> slot2probe;
+
+    // Rows missing from both the current and the legacy tables, until they are written
+    mutable std::set<evmc::address> absent_accounts;
+    mutable std::set<std::pair<uint64_t, evmc::bytes32>> absent_slots;
+
+    // Changes to the storage usage of accounts, by account id
+    struct usage_delta {
+        int64_t slots = 0;
+        int64_t bytes = 0;
+    };
+    std::map<uint64_t, usage_delta> usage_deltas;
+
+    // account id, slot id, location
+    using slot_write = std::tuple<uint64_t, uint64_t, evmc::bytes32>;
+    std::map<slot_write, evmc::bytes32> pending_slots;
+
+    account_probe probe_account(const evmc::address& address) const;
+    std::optional<uint64_t> find_account_id(const evmc::address& address) const;
+    account_probe load_account(const evmc::address& address);
+    account2_table::const_iterator emplace_account(const account2& row);
+    void retire_account(account2_table::const_iterator itr);
+    bool has_legacy_accounts() const;
+    std::optional<account2> find_legacy_account(const evmc::address& address) const;
+    account2_table::const_iterator migrate_account_row(account_table& legacy, account_table::const_iterator itr, uint64_t key);
+    account2_table::const_iterator create_account(uint64_t key, const evmc::address& address,
+                                                  uint64_t nonce = 0, const uint256& balance = 0);
+    slot_probe probe_slot(uint64_t account_id, const evmc::bytes32& location) const;
+    void forget_slots(uint64_t account_id, bool misses_only);
+    bool has_legacy_storage(uint64_t account_id) const;
+    void apply_usage_deltas();
+    gc_progress load_gc_progress() const;
+    void store_slot(uint64_t account_id, const evmc::bytes32& location, const evmc::bytes32& value);
+    ByteView cache_code(const bytes32& code_hash, const bytes& code, const code_analysis* analysis) const;
+    uint64_t next_code_id() const;
+    account_code_table::const_iterator migrate_code_row(account_code_table& codes, account_code_table::const_iterator itr, int32_t ref_delta);
 };
 
 }  // namespace evm_runtime
@@ -8,12 +8,14 @@
 
 #include <evm_runtime/types.hpp>
 #include <evm_runtime/runtime_config.hpp>
+#include <evm_runtime/code_analysis.hpp>
 #include <eosevm/block_mapping.hpp>
 
 #include <silkworm/core/common/base.hpp>
 namespace evm_runtime {
 
 using namespace eosio;
+// Legacy account layout, rows are moved to `account2` when written or by `migrateacct`
 struct [[eosio::table]] [[eosio::contract("evm_contract")]] account {
     enum class flag : uint32_t {
         frozen = 0x1
@@ -57,6 +59,64 @@ typedef multi_index< "account"_n, account,
     indexed_by<"by.address"_n, const_mem_fun<account, checksum256, &account::by_eth_address>>
 > account_table;
 
+// Accounts keyed by the leading 64 bits of keccak256(address) (see state::probe_account). On collision
+// the following keys are probed, `id` stays the stable account id used as the scope of its storage.
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] account2 {
+    uint64_t    key;
+    uint64_t    id;
+    checksum160 eth_address;
+    uint64_t    nonce;
+    checksum256 balance;
+    std::optional<uint64_t> code_id;
+    uint32_t    flags = 0;
+    binary_extension<storage_usage> usage; // unset for accounts moved from `account`, their storage is not counted
+
+    void set_flag(account::flag f) {
+        flags |= static_cast<uint32_t>(f);
+    }
+
+    void clear_flag(account::flag f) {
+        flags &= ~static_cast<uint32_t>(f);
+    }
+
+    inline bool has_flag(account::flag f)const {
+        return (flags & static_cast<uint32_t>(f)) != 0;
+    }
+
+    uint64_t primary_key()const { return key; }
+
+    uint64_t by_id()const { return id; }
+
+    evmc::address get_address()const {
+        evmc::address res;
+        const auto arr = eth_address.extract_as_byte_array();
+        std::copy(arr.begin(), arr.end(), res.bytes);
+        return res;
+    }
+
+    void set_address(const evmc::address& address) {
+        eth_address = checksum160(address.bytes);
+    }
+
+    uint256 get_balance()const {
+        const auto arr = balance.extract_as_byte_array();
+        return intx::be::unsafe::load<uint256>(arr.data());
+    }
+
+    void set_balance(const uint256& value) {
+        uint8_t buffer[32];
+        intx::be::store(buffer, value);
+        balance = checksum256(buffer);
+    }
+
+    EOSLIB_SERIALIZE(account2, (key)(id)(eth_address)(nonce)(balance)(code_id)(flags)(usage));
+};
+
+typedef multi_index< "account2"_n, account2,
+    indexed_by<"by.id"_n, const_mem_fun<account2, uint64_t, &account2::by_id>>
+> account2_table;
+
+// Legacy code table, rows are moved to `codemeta`/`codeblob` when touched or by `migratecode`
 struct [[eosio::table]] [[eosio::contract("evm_contract")]] account_code {
     uint64_t    id;
     uint32_t    ref_count;
@@ -80,6 +140,42 @@ typedef multi_index< "accountcode"_n, account_code,
     indexed_by<"by.codehash"_n, const_mem_fun<account_code, checksum256, &account_code::by_code_hash>>
 > account_code_table;
 
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] code_meta {
+    uint64_t    id;
+    uint32_t    ref_count;
+    bytes       code_hash;
+
+    uint64_t primary_key()const { return id; }
+
+    checksum256 by_code_hash()const {
+        return make_key(code_hash);
+    }
+
+    bytes32 get_code_hash()const {
+        return to_bytes32(code_hash);
+    }
+
+    EOSLIB_SERIALIZE(code_meta, (id)(ref_count)(code_hash));
+};
+
+typedef multi_index< "codemeta"_n, code_meta,
+    indexed_by<"by.codehash"_n, const_mem_fun<code_meta, checksum256, &code_meta::by_code_hash>>
+> code_meta_table;
+
+// Shares its primary key with the `codemeta` row
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] code_blob {
+    uint64_t      id;
+    bytes         code;
+    code_analysis analysis;
+
+    uint64_t primary_key()const { return id; }
+
+    EOSLIB_SERIALIZE(code_blob, (id)(code)(analysis));
+};
+
+typedef multi_index< "codeblob"_n, code_blob> code_blob_table;
+
+// Legacy storage layout, rows are moved to `storage2` when written or by `migratestor`
 struct [[eosio::table]] [[eosio::contract("evm_contract")]] storage {
     uint64_t id;
     bytes    key;
@@ -98,6 +194,33 @@ typedef multi_index< "storage"_n, storage,
     indexed_by<"by.key"_n, const_mem_fun<storage, checksum256, &storage::by_key>> 
 > storage_table;
 
+// Storage slots keyed by an id derived from the slot (see state::store_slot). On collision the
+// following ids are probed. A row with a zero value is free; it is kept when it links a probe chain.
+// Keys and values are stored without their leading zero bytes (see to_compact_bytes), most slots
+// are low-numbered and hold small numbers.
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] storage2 {
+    uint64_t id;
+    bytes    key;
+    bytes    value;
+
+    uint64_t primary_key()const { return id; }
+
+    bool is_free()const { return value.empty(); }
+
+    EOSLIB_SERIALIZE(storage2, (id)(key)(value));
+};
+
+typedef multi_index< "storage2"_n, storage2> storage2_table;
+
+// Next account whose `storage` scope is to be compacted into `storage2` by `migratestor`
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] storage_migration {
+    uint64_t next_account_id = 0;
+
+    EOSLIB_SERIALIZE(storage_migration, (next_account_id));
+};
+
+typedef eosio::singleton<"stormig"_n, storage_migration> storage_migration_singleton;
+
 struct [[eosio::table]] [[eosio::contract("evm_contract")]] gcstore {
     uint64_t id;
     uint64_t storage_id;
@@ -109,6 +232,22 @@ struct [[eosio::table]] [[eosio::contract("evm_contract")]] gcstore {
 
 typedef multi_index< "gcstore"_n, gcstore> gc_store_table;
 
+// Entry `gc` resumes from and number of `gcstore` entries. A backlog left by an older contract is
+// counted by `countgc`, until then `entries` only covers the entries below `uncounted_from`
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] gc_progress {
+    uint64_t next_id = 0;
+    uint64_t entries = 0;
+    binary_extension<uint64_t> uncounted_from; // <- default(unset) means all entries are counted
+
+    bool is_counted(uint64_t id) const {
+        return !uncounted_from.has_value() || id < *uncounted_from;
+    }
+
+    EOSLIB_SERIALIZE(gc_progress, (next_id)(entries)(uncounted_from));
+};
+
+typedef eosio::singleton<"gcprogress"_n, gc_progress> gc_progress_singleton;
+
 struct [[eosio::table("inevm")]] [[eosio::contract("evm_contract")]] balance_with_dust {
     asset balance;
     uint64_t dust = 0;
@@ -205,6 +344,22 @@ struct [[eosio::table]] [[eosio::contract("evm_contract")]] nextnonce {
 
 typedef eosio::multi_index<"nextnonces"_n, nextnonce> nextnonces;
 
+// Balance and next nonce of an opened account, one row per owner. Legacy `balances` and `nextnonces`
+// rows are merged into it when the owner is first looked up or by `migratevault`. An account closed
+// after using its nonce keeps the row, not open, so that the nonce survives re-opening it.
+struct [[eosio::table]] [[eosio::contract("evm_contract")]] vault {
+    name              owner;
+    balance_with_dust balance;
+    uint64_t          next_nonce = 0;
+    bool              open = true;
+
+    uint64_t primary_key() const { return owner.value; }
+
+    EOSLIB_SERIALIZE(vault, (owner)(balance)(next_nonce)(open));
+};
+
+typedef eosio::multi_index<"vaults"_n, vault> vaults;
+
 struct [[eosio::table]] [[eosio::contract("evm_contract")]] allowed_egress_account {
     name account;
 
@@ -347,7 +502,14 @@ struct [[eosio::table]] [[eosio::contract("evm_contract")]] config
 
     binary_extension<eosio::name> token_contract; // <- default(unset) means eosio.token
 
-    EOSLIB_SERIALIZE(config, (version)(chainid)(genesis_time)(ingress_bridge_fee)(gas_price)(miner_cut)(status)(evm_version)(consensus_parameter)(token_contract));
+    binary_extension<uint32_t> gc_budget; // <- storage rows collected by each transaction action, default(unset) means none
+    binary_extension<uint32_t> max_inline_erase_slots; // <- default(unset) means storage is always left to gc
+
+    binary_extension<uint64_t> next_price_block; // <- block of the front of pricequeue, 0 if empty, default(unset) means not known yet
+
+    binary_extension<uint32_t> event_flags; // <- bit mask values from event_flags, default(unset) means none
+
+    EOSLIB_SERIALIZE(config, (version)(chainid)(genesis_time)(ingress_bridge_fee)(gas_price)(miner_cut)(status)(evm_version)(consensus_parameter)(token_contract)(gc_budget)(max_inline_erase_slots)(next_price_block)(event_flags));
 };
 
 struct [[eosio::table]] [[eosio::contract("evm_contract")]] price_queue
@@ -3,6 +3,8 @@
 #include <optional>
 #include <eosio/eosio.hpp>
 #include <evm_runtime/types.hpp>
+#include <evm_runtime/intrinsics.hpp>
+#include <ethash/keccak.hpp>
 #include <silkworm/core/rlp/encode.hpp>
 #include <silkworm/core/types/transaction.hpp>
 
@@ -14,9 +16,14 @@ using silkworm::ByteView;
 struct transaction {
 
   transaction() = delete;
-  explicit transaction(bytes rlptx) : rlptx_(std::move(rlptx)) {}
+  explicit transaction(bytes rlptx) : rlptx_(std::move(rlptx)), in_action_data_(true) {}
   explicit transaction(silkworm::Transaction tx) : tx_(std::move(tx)) {}
 
+  // True when the rlp came from the action data (pushtx, pushtxs), false when the contract built the transaction
+  bool in_action_data()const {
+    return in_action_data_;
+  }
+
   const bytes& get_rlptx()const {
     if(!rlptx_) {
       eosio::check(tx_.has_value(), "no tx");
@@ -27,13 +34,21 @@ struct transaction {
     return rlptx_.value();
   }
 
+  // Hands the rlp over to the caller, the transaction must not be asked for it again
+  bytes release_rlptx() {
+    get_rlptx();
+    bytes res = std::move(rlptx_.value());
+    rlptx_.reset();
+    return res;
+  }
+
   const silkworm::Transaction& get_tx()const {
     if(!tx_) {
       eosio::check(rlptx_.has_value(), "no rlptx");
       ByteView bv{(const uint8_t*)rlptx_->data(), rlptx_->size()};
-      silkworm::Transaction tmp;
-      eosio::check(silkworm::rlp::decode_transaction(bv, tmp, silkworm::rlp::Eip2718Wrapping::kBoth) && bv.empty(), "unable to decode transaction");
-      tx_.emplace(tmp);
+      // Decode in place, calldata and access list are only copied out of the rlp once
+      auto& tx = tx_.emplace();
+      eosio::check(silkworm::rlp::decode_transaction(bv, tx, silkworm::rlp::Eip2718Wrapping::kBoth) && bv.empty(), "unable to decode transaction");
     }
     return tx_.value();
   }
@@ -42,12 +57,46 @@ struct transaction {
     eosio::check(tx_.has_value(), "no tx");
     auto& tx = tx_.value();
     tx.from.reset();
+#ifdef WITH_K1_RECOVER
+    // Special signatures do not involve any elliptic curve math, let silkworm resolve them.
+    if(!silkworm::is_special_signature(tx.r, tx.s)) {
+      tx.from = recover_sender_k1(tx);
+      return;
+    }
+#endif
     tx.recover_sender();
   }
 
+#ifdef WITH_K1_RECOVER
+  // Recover the sender using the k1_recover host function instead of the in-WASM secp256k1.
+  static std::optional<evmc::address> recover_sender_k1(const silkworm::Transaction& tx) {
+    Bytes rlp;
+    tx.encode_for_signing(rlp);
+    const auto digest = ethash::keccak256(rlp.data(), rlp.size());
+
+    // [v|r|s] with v in compact form (27 + recovery id)
+    char sig[65];
+    sig[0] = static_cast<char>(27 + (tx.odd_y_parity ? 1 : 0));
+    intx::be::unsafe::store(reinterpret_cast<uint8_t*>(sig + 1), tx.r);
+    intx::be::unsafe::store(reinterpret_cast<uint8_t*>(sig + 33), tx.s);
+
+    char pub[65];
+    if(eosio::internal_use_do_not_use::k1_recover(sig, sizeof(sig), reinterpret_cast<const char*>(digest.bytes), sizeof(digest.bytes), pub, sizeof(pub)) != 0) {
+      return {};
+    }
+
+    // Ignore first byte of the uncompressed public key
+    const auto key_hash = ethash::keccak256(reinterpret_cast<const uint8_t*>(pub + 1), 64);
+    evmc::address res;
+    std::memcpy(res.bytes, key_hash.bytes + 12, sizeof(res.bytes));
+    return res;
+  }
+#endif
+
 private:
   mutable std::optional<bytes>  rlptx_;
   mutable std::optional<silkworm::Transaction> tx_;
+  bool in_action_data_ = false;
 };
 
 } //namespace evm_runtime
\ No newline at end of file
@@ -43,6 +43,10 @@ namespace evm_runtime {
 
    evmc::address to_address(const bytes& addr);
    evmc::bytes32 to_bytes32(const bytes& data);
+
+   // Big endian words without their leading zero bytes, zero is empty
+   bytes to_compact_bytes(const evmc::bytes32& val);
+   evmc::bytes32 from_compact_bytes(const bytes& data);
    uint256 to_uint256(const bytes& value);
 
    struct exec_input {
@@ -82,6 +86,36 @@ namespace evm_runtime {
 
    using bridge_message = std::variant<bridge_message_v0>;
 
+   struct storage_usage {
+      uint32_t slots = 0; // rows in `storage2`, free ones included
+      uint32_t bytes = 0; // serialized size of those rows
+
+      EOSLIB_SERIALIZE(storage_usage, (slots)(bytes));
+   };
+
+   struct gc_result {
+      uint32_t rows_deleted = 0;      // storage rows erased by the call
+      uint32_t entries_completed = 0; // `gcstore` entries whose storage is all gone
+      uint64_t backlog = 0;           // `gcstore` entries left
+
+      EOSLIB_SERIALIZE(gc_result, (rows_deleted)(entries_completed)(backlog));
+   };
+
+   struct gc_backlog_entry {
+      uint64_t id;
+      uint64_t storage_id;
+      uint32_t rows; // rows left in the storage scope, counted up to the requested limit
+
+      EOSLIB_SERIALIZE(gc_backlog_entry, (id)(storage_id)(rows));
+   };
+
+   struct gc_backlog {
+      uint64_t                      entries = 0;
+      std::vector<gc_backlog_entry> next; // entries in the order `gc` will visit them
+
+      EOSLIB_SERIALIZE(gc_backlog, (entries)(next));
+   };
+
    struct evmtx_v0 {
       uint64_t  eos_evm_version;
       bytes     rlptx;
@@ -90,7 +124,77 @@ namespace evm_runtime {
       EOSLIB_SERIALIZE(evmtx_v0, (eos_evm_version)(rlptx)(base_fee_per_gas));
    };
 
-   using evmtx_type = std::variant<evmtx_v0>;
+   // Sent instead of the v0 events when event_flags::compact_evmtx is set. Transactions pushed with
+   // pushtx or pushtxs are not repeated, their rlp is in the data of the action that created the event
+   // and rlp_hashes tells which ones they are. A batch with any transaction built by the contract
+   // carries all of its rlp instead.
+   struct evmtx_v1 {
+      uint64_t            eos_evm_version;
+      uint64_t            base_fee_per_gas;
+      uint32_t            tx_count;
+      std::vector<bytes>  rlptxs;     // <- empty for pushed transactions, otherwise all tx_count of them
+      std::vector<bytes>  rlp_hashes; // <- keccak256 of each pushed rlp, empty when rlptxs is not
+
+      EOSLIB_SERIALIZE(evmtx_v1, (eos_evm_version)(base_fee_per_gas)(tx_count)(rlptxs)(rlp_hashes));
+   };
+
+   using evmtx_type = std::variant<evmtx_v0, evmtx_v1>;
+
+   struct account_change {
+      bytes                   address;
+      std::optional<uint64_t> nonce;         // <- unset if the account was removed
+      bytes                   balance;       // <- big endian without leading zeros
+      bool                    fresh = false; // <- code and storage of an earlier incarnation are gone
+
+      EOSLIB_SERIALIZE(account_change, (address)(nonce)(balance)(fresh));
+   };
+
+   struct code_change {
+      bytes    address;
+      uint64_t code_id;
+      bytes    code_hash;
+
+      EOSLIB_SERIALIZE(code_change, (address)(code_id)(code_hash));
+   };
+
+   struct storage_change {
+      bytes address;
+      bytes key;   // <- big endian without leading zeros
+      bytes value; // <- big endian without leading zeros, empty removes the slot
+
+      EOSLIB_SERIALIZE(storage_change, (address)(key)(value));
+   };
+
+   struct log_entry {
+      bytes              address;
+      std::vector<bytes> topics;
+      bytes              data;
+
+      EOSLIB_SERIALIZE(log_entry, (address)(topics)(data));
+   };
+
+   struct tx_result {
+      bool                   success;
+      uint64_t               gas_used;
+      std::vector<log_entry> logs;
+
+      EOSLIB_SERIALIZE(tx_result, (success)(gas_used)(logs));
+   };
+
+   // Sent after evmtx when event_flags::state_diff is set. Holds the outcome of each transaction of the
+   // action and the state they left behind, applying accounts, then codes, then storage rebuilds it.
+   struct statediff_v0 {
+      uint64_t                    eos_evm_version;
+      uint64_t                    block_num;
+      std::vector<tx_result>      txs;
+      std::vector<account_change> accounts;
+      std::vector<code_change>    codes;
+      std::vector<storage_change> storage;
+
+      EOSLIB_SERIALIZE(statediff_v0, (eos_evm_version)(block_num)(txs)(accounts)(codes)(storage));
+   };
+
+   using statediff_type = std::variant<statediff_v0>;
 
    struct fee_parameters
    {
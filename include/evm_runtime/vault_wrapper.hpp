@@ -0,0 +1,69 @@
+#pragma once
+#include <map>
+#include <optional>
+#include <eosio/eosio.hpp>
+#include <eosio/asset.hpp>
+#include <evm_runtime/tables.hpp>
+namespace evm_runtime {
+
+// Access to the `vaults` table for the duration of an action. Rows read once stay in the item
+// cache of the table, so the nonce and the balance of an owner are looked up a single time.
+struct vault_wrapper {
+
+    /// @param first_receiver receiver of the action, not the contract in a notification
+    vault_wrapper(eosio::name self, eosio::name first_receiver);
+    ~vault_wrapper();
+
+    /// @return the vault of an open account, nullptr if the account is not open. Its balance
+    /// does not include the changes not flushed yet.
+    const vault* find(eosio::name owner);
+    const vault& get(eosio::name owner, const char* error);
+
+    template <typename Lambda>
+    void modify(const vault& row, Lambda&& updater) {
+        _vaults.modify(row, eosio::same_payer, [&](vault& v) {
+            take_pending(v);
+            updater(v);
+        });
+    }
+
+    /// Balance changes are applied right away to a copy of the balance, with the usual overflow
+    /// and underflow checks, and written to the row once by flush, along with the nonce
+    void add(const vault& row, const intx::uint256& amount);
+    void add(const vault& row, const eosio::asset& quantity);
+    void subtract(const vault& row, const intx::uint256& amount);
+    void flush();
+
+    void open(eosio::name owner, const eosio::symbol& token_symbol);
+    void close(eosio::name owner);
+
+    /// @return next nonce of the owner, also of an account closed after using it
+    uint64_t get_next_nonce(eosio::name owner);
+    uint64_t get_and_increment_nonce(eosio::name owner);
+
+    /// Merges up to `max` owners of the legacy tables into `vaults`
+    /// @return true if no legacy rows are left
+    bool migrate(uint32_t max);
+
+private:
+    vaults::const_iterator load(eosio::name owner);
+    vaults::const_iterator migrate_owner(eosio::name owner);
+    bool has_legacy_rows();
+    struct pending_change {
+        const vault*      row;
+        balance_with_dust balance;
+        uint64_t          next_nonce;
+    };
+
+    pending_change& pending(const vault& row);
+    balance_with_dust& pending_balance(const vault& row);
+    void take_pending(vault& row);
+
+    eosio::name                           _self;
+    eosio::name                           _first_receiver;
+    vaults                                _vaults;
+    std::optional<bool>                   _has_legacy_rows;
+    std::map<eosio::name, pending_change> _pending;
+};
+
+} //namespace evm_runtime
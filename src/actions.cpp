@@ -9,6 +9,7 @@
 #include <evm_runtime/eosio.token.hpp>
 #include <evm_runtime/bridge.hpp>
 #include <evm_runtime/config_wrapper.hpp>
+#include <evm_runtime/vault_wrapper.hpp>
 
 #include <silkworm/core/protocol/trust_rule_set.hpp>
 // included here so NDEBUG is defined to disable assert macro
@@ -38,7 +39,8 @@ static constexpr char err_msg_invalid_addr[] = "invalid address";
 using namespace silkworm;
 
 evm_contract::evm_contract(eosio::name receiver, eosio::name code, const datastream<const char*>& ds) : 
-        contract(receiver, code, ds), _config(std::make_shared<config_wrapper>(get_self())) {}
+        contract(receiver, code, ds), _config(std::make_shared<config_wrapper>(get_self())),
+        _vaults(std::make_shared<vault_wrapper>(get_self(), code)) {}
 
 void evm_contract::assert_inited()
 {
@@ -180,29 +182,11 @@ void check_result( ValidationResult r, const Transaction& txn, const char* desc
     eosio::check( false, std::move(err_msg));
 }
 
-Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Block& block, const transaction& txn, silkworm::ExecutionProcessor& ep) {
+Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Block& block, const transaction& txn, silkworm::ExecutionProcessor& ep, tx_accumulator& acc) {
     const auto& tx = txn.get_tx();
-    balances balance_table(get_self(), get_self().value);
-
-    if (miner == get_self()) {
-        // If the miner is the contract itself, then there is no need to send the miner its cut.
-        miner = {};
-    }
-
-    if (miner) {
-        // Ensure the miner has a balance open early.
-        balance_table.get(miner.value, "no balance open for miner");
-    }
 
     bool deducted_miner_cut = false;
 
-    std::optional<inevm_singleton> inevm;
-    auto populate_bridge_accessors = [&]() {
-        if(inevm)
-            return;
-        inevm.emplace(get_self(), get_self().value);
-    };
-
     bool is_special_signature = silkworm::is_special_signature(tx.r, tx.s);
 
     txn.recover_sender();
@@ -222,11 +206,8 @@ Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Bl
             check(max_gas_cost + tx.value < std::numeric_limits<intx::uint256>::max(), "too much gas");
             const intx::uint256 value_with_max_gas = tx.value + (intx::uint256)max_gas_cost;
 
-            populate_bridge_accessors();
-            balance_table.modify(balance_table.get(ingress_account.value), eosio::same_payer, [&](balance& b){
-                b.balance -= value_with_max_gas;
-            });
-            inevm->set(inevm->get() += value_with_max_gas, eosio::same_payer);
+            _vaults->subtract(_vaults->get(ingress_account, "account is not open"), value_with_max_gas);
+            acc.inevm_credit += value_with_max_gas;
 
             ep.state().set_balance(*tx.from, value_with_max_gas);
             ep.state().set_nonce(*tx.from, tx.nonce);
@@ -253,7 +234,7 @@ Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Bl
     // Calculate the miner portion of the actual gas fee (if necessary):
     std::optional<intx::uint256> gas_fee_miner_portion;
     if (miner) {
-        uint64_t tx_gas_used = receipt.cumulative_gas_used; // Only transaction in the "block" so cumulative_gas_used is the tx gas_used.
+        uint64_t tx_gas_used = receipt.cumulative_gas_used - acc.cumulative_gas_used;
         if(_config->get_evm_version() >= 1) {
             eosio::check(ep.evm().block().header.base_fee_per_gas.has_value(), "no base fee");
             intx::uint512 gas_fee = intx::uint256(tx_gas_used) * tx.priority_fee_per_gas(ep.evm().block().header.base_fee_per_gas.value());
@@ -268,13 +249,15 @@ Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Bl
         }
     }
 
+    acc.cumulative_gas_used = receipt.cumulative_gas_used;
+
     if (rc.abort_on_failure)
         eosio::check(receipt.success, "tx executed inline by contract must succeed");
 
     if(!ep.state().reserved_objects().empty()) {
         bool non_open_account_sent = false;
         intx::uint256 total_egress;
-        populate_bridge_accessors();
+        std::vector<evmc::address> bridged;
 
         for(const auto& reserved_object : ep.state().reserved_objects()) {
             const evmc::address& address = reserved_object.first;
@@ -287,16 +270,15 @@ Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Bl
             if(reserved_account.balance ==  0_u256)
                 continue;
             total_egress += reserved_account.balance;
-
-            if(auto it = balance_table.find(egress_account.value); it != balance_table.end()) {
-                balance_table.modify(balance_table.get(egress_account.value), eosio::same_payer, [&](balance& b){
-                    b.balance += reserved_account.balance;
-                    if (gas_fee_miner_portion.has_value() && egress_account == get_self()) {
-                        check(!deducted_miner_cut, "unexpected error: contract account appears twice in reserved objects");
-                        b.balance -= *gas_fee_miner_portion;
-                        deducted_miner_cut = true;
-                    }
-                });
+            bridged.push_back(address);
+
+            if(const vault* v = _vaults->find(egress_account)) {
+                _vaults->add(*v, reserved_account.balance);
+                if (gas_fee_miner_portion.has_value() && egress_account == get_self()) {
+                    check(!deducted_miner_cut, "unexpected error: contract account appears twice in reserved objects");
+                    _vaults->subtract(*v, *gas_fee_miner_portion);
+                    deducted_miner_cut = true;
+                }
             }
             else {
                 check(!non_open_account_sent, "only one non-open account for egress bridging allowed in single transaction");
@@ -318,16 +300,19 @@ Receipt evm_contract::execute_tx(const runtime_config& rc, eosio::name miner, Bl
             }
         }
 
-        if(total_egress != 0_u256)
-            inevm->set(inevm->get() -= total_egress, eosio::same_payer);
+        acc.inevm_debit += total_egress;
+
+        // Reserved objects live for the whole block; drain the bridged balances so that the next
+        // transaction executed against the same state does not bridge them a second time.
+        for(const auto& address : bridged) {
+            ep.state().set_balance(address, 0);
+        }
     }
 
-    // Send miner portion of the gas fee, if any, to the balance of the miner:
+    // Miner portion of the gas fee, if any, is credited to the balance of the miner by settle_txs.
     if (gas_fee_miner_portion.has_value() && *gas_fee_miner_portion != 0) {
         check(deducted_miner_cut, "unexpected error: contract account did not receive any funds through its reserved address");
-        balance_table.modify(balance_table.get(miner.value), eosio::same_payer, [&](balance& b){
-            b.balance += *gas_fee_miner_portion;
-        });
+        acc.miner_fee += *gas_fee_miner_portion;
     }
 
     LOGTIME("EVM EXECUTE");
@@ -419,8 +404,7 @@ void evm_contract::process_filtered_messages(const std::vector<silkworm::Filtere
         auto value = intx::be::unsafe::load<uint256>(rawmsg.value.bytes);
         eosio::check(value >= min_fee, "min_fee not covered");
 
-        balances balance_table(get_self(), get_self().value);
-        const balance& receiver_account = balance_table.get(receiver.value, "receiver account is not open");
+        const vault& receiver_account = _vaults->get(receiver, "receiver account is not open");
 
         action(std::vector<permission_level>{}, it->handler, "onbridgemsg"_n,
             bridge_message{ bridge_message_v0 {
@@ -432,27 +416,36 @@ void evm_contract::process_filtered_messages(const std::vector<silkworm::Filtere
             } }
         ).send();
 
-        balance_table.modify(receiver_account, eosio::same_payer, [&](balance& row) {
-            row.balance += value;
-        });
+        _vaults->add(receiver_account, value);
 
         accumulated_value += value;
     }
 
     if(accumulated_value > 0) {
-        balances balance_table(get_self(), get_self().value);
-        const balance& self_balance = balance_table.get(get_self().value);
-        balance_table.modify(self_balance, eosio::same_payer, [&](balance& row) {
-            row.balance -= accumulated_value;
-        });
+        _vaults->subtract(_vaults->get(get_self(), "account is not open"), accumulated_value);
+    }
+
+}
+
+void evm_contract::settle_txs(eosio::name miner, const tx_accumulator& acc) {
+    if (acc.inevm_credit != 0 || acc.inevm_debit != 0) {
+        inevm_singleton inevm(get_self(), get_self().value);
+        auto in_evm = inevm.get();
+        if (acc.inevm_credit != 0) in_evm += acc.inevm_credit;
+        if (acc.inevm_debit != 0) in_evm -= acc.inevm_debit;
+        inevm.set(in_evm, eosio::same_payer);
     }
 
+    // Send the accumulated miner portion of the gas fees, if any, to the balance of the miner:
+    if (acc.miner_fee != 0) {
+        _vaults->add(_vaults->get(miner, "no balance open for miner"), acc.miner_fee);
+    }
 }
 
-void evm_contract::process_tx(const runtime_config& rc, eosio::name miner, const transaction& txn, std::optional<uint64_t> min_inclusion_price) {
+void evm_contract::process_txs(const runtime_config& rc, eosio::name miner, std::vector<transaction>& txs, std::optional<uint64_t> min_inclusion_price) {
     LOGTIME("EVM START1");
 
-    const auto& tx = txn.get_tx();
+    eosio::check(!txs.empty(), "no transactions");
     eosio::check(rc.allow_non_self_miner || miner == get_self(),
                  "unexpected error: EVM contract generated inline pushtx without setting itself as the miner");
 
@@ -482,6 +475,7 @@ void evm_contract::process_tx(const runtime_config& rc, eosio::name miner, const
     silkworm::protocol::TrustRuleSet engine{*found_chain_config->second};
 
     evm_runtime::state state{get_self(), get_self(), false, false};
+    state._max_inline_erase_slots = _config->get_max_inline_erase_slots();
 
     auto gas_params = std::visit([&](const auto &v) {
         return evmone::gas_parameters(
@@ -495,14 +489,6 @@ void evm_contract::process_tx(const runtime_config& rc, eosio::name miner, const
 
     silkworm::ExecutionProcessor ep{block, engine, state, *found_chain_config->second, gas_params};
 
-    if (current_version >= 1) {
-        auto inclusion_price = std::min(tx.max_priority_fee_per_gas, tx.max_fee_per_gas - *base_fee_per_gas);
-        eosio::check(inclusion_price >= (min_inclusion_price.has_value() ? *min_inclusion_price : 0), "inclusion price must >= min_inclusion_price");
-    } else { // old behavior
-        check(tx.max_priority_fee_per_gas == tx.max_fee_per_gas, "max_priority_fee_per_gas must be equal to max_fee_per_gas");
-        check(tx.max_fee_per_gas >= _config->get_gas_price(), "gas price is too low");
-    }
-
     // Filter EVM messages (with data) that are sent to the reserved address
     // corresponding to the EOS account holding the contract (self)
     ep.set_evm_message_filter([&](const evmc_message& message) -> bool {
@@ -510,12 +496,61 @@ void evm_contract::process_tx(const runtime_config& rc, eosio::name miner, const
         return message.recipient == me && message.input_size > 0;
     });
 
-    auto receipt = execute_tx(rc, miner, block, txn, ep);
+    if (miner == get_self()) {
+        // If the miner is the contract itself, then there is no need to send the miner its cut.
+        miner = {};
+    }
 
-    process_filtered_messages(ep.state().filtered_messages());
+    if (miner) {
+        // Ensure the miner has a balance open early.
+        _vaults->get(miner, "no balance open for miner");
+    }
+
+    if (current_version >= 1 && (_config->get_event_flags() & static_cast<uint32_t>(event_flags::state_diff))) {
+        state.changes.emplace(statediff_v0{.eos_evm_version = current_version, .block_num = block.header.number});
+    }
+
+    tx_accumulator acc;
+    for (const auto& txn : txs) {
+        const auto& tx = txn.get_tx();
+        if (current_version >= 1) {
+            auto inclusion_price = std::min(tx.max_priority_fee_per_gas, tx.max_fee_per_gas - *base_fee_per_gas);
+            eosio::check(inclusion_price >= (min_inclusion_price.has_value() ? *min_inclusion_price : 0), "inclusion price must >= min_inclusion_price");
+        } else { // old behavior
+            check(tx.max_priority_fee_per_gas == tx.max_fee_per_gas, "max_priority_fee_per_gas must be equal to max_fee_per_gas");
+            check(tx.max_fee_per_gas >= _config->get_gas_price(), "gas price is too low");
+        }
+
+        state.warm_up(tx.access_list);
+        const auto gas_used_before = acc.cumulative_gas_used;
+        auto receipt = execute_tx(rc, miner, block, txn, ep, acc);
+        // Filtered messages belong to the substate of a single transaction, the next one clears them
+        process_filtered_messages(ep.state().filtered_messages());
+
+        if (state.changes) {
+            tx_result result{receipt.success, receipt.cumulative_gas_used - gas_used_before, {}};
+            result.logs.reserve(receipt.logs.size());
+            for (const auto& log : receipt.logs) {
+                log_entry entry{to_bytes(log.address), {}, bytes{log.data.begin(), log.data.end()}};
+                entry.topics.reserve(log.topics.size());
+                for (const auto& topic : log.topics) {
+                    entry.topics.push_back(to_bytes(topic));
+                }
+                result.logs.push_back(std::move(entry));
+            }
+            state.changes->txs.push_back(std::move(result));
+        }
+    }
+
+    settle_txs(miner, acc);
 
     engine.finalize(ep.state(), ep.evm().block());
     ep.state().write_to_db(ep.evm().block().header.number);
+    state.flush();
+
+    if (auto budget = _config->get_gc_budget()) {
+        state.gc(budget);
+    }
 
     if (gas_param_pair.second) {
         configchange_action act{get_self(), std::vector<eosio::permission_level>()};
@@ -523,8 +558,41 @@ void evm_contract::process_tx(const runtime_config& rc, eosio::name miner, const
     }
 
     if (current_version >= 1) {
-        auto event = evmtx_type{evmtx_v0{current_version, txn.get_rlptx(), *base_fee_per_gas}};
-        action(std::vector<permission_level>{}, get_self(), "evmtx"_n, event)
+        // The transactions are done with, move their rlp into the event instead of copying it
+        if (_config->get_event_flags() & static_cast<uint32_t>(event_flags::compact_evmtx)) {
+            evmtx_v1 compact{current_version, *base_fee_per_gas, static_cast<uint32_t>(txs.size()), {}, {}};
+            const bool pushed = std::all_of(txs.begin(), txs.end(), [](const transaction& txn) {
+                return txn.in_action_data();
+            });
+            if (pushed) {
+                compact.rlp_hashes.reserve(txs.size());
+                for (const auto& txn : txs) {
+                    const auto& rlp = txn.get_rlptx();
+                    const auto hash = ethash::keccak256(reinterpret_cast<const uint8_t*>(rlp.data()), rlp.size());
+                    compact.rlp_hashes.emplace_back(hash.bytes, hash.bytes + sizeof(hash.bytes));
+                }
+            } else {
+                compact.rlptxs.reserve(txs.size());
+                for (auto& txn : txs) {
+                    compact.rlptxs.push_back(txn.release_rlptx());
+                }
+            }
+            evmtx_type event = std::move(compact);
+            action(std::vector<permission_level>{}, get_self(), "evmtx"_n, event)
+                .send();
+        } else {
+            // One v0 event per transaction, as for pushtx, so existing readers follow batches too
+            for (auto& txn : txs) {
+                evmtx_type event = evmtx_v0{current_version, txn.release_rlptx(), *base_fee_per_gas};
+                action(std::vector<permission_level>{}, get_self(), "evmtx"_n, event)
+                    .send();
+            }
+        }
+    }
+
+    if (state.changes) {
+        statediff_type event = std::move(*state.changes);
+        action(std::vector<permission_level>{}, get_self(), "statediff"_n, event)
             .send();
     }
     LOGTIME("EVM END");
@@ -566,7 +634,38 @@ void evm_contract::pushtx(eosio::name miner, bytes rlptx, eosio::binary_extensio
         check(evm_version >= 1, "min_inclusion_price requires evm_version >= 1");
     }
 
-    process_tx(rc, miner, transaction{std::move(rlptx)}, min_inclusion_price_);
+    std::vector<transaction> txs;
+    txs.emplace_back(std::move(rlptx));
+    process_txs(rc, miner, txs, min_inclusion_price_);
+}
+
+void evm_contract::pushtxs(eosio::name miner, std::vector<bytes> rlptxs, eosio::binary_extension<uint64_t> min_inclusion_price) {
+    LOGTIME("EVM START0");
+    assert_unfrozen();
+
+    // Batches are only accepted from external miners, the contract itself always dispatches single
+    // transactions through pushtx.
+    eosio::check(get_sender() != get_self(), "pushtxs cannot be sent inline by the contract");
+
+    // Before version 1 there is no evmtx event to tell nodes which transactions an action holds
+    auto evm_version = _config->get_evm_version();
+    check(evm_version >= 1, "pushtxs requires evm_version >= 1");
+    _config->process_price_queue();
+
+    std::optional<uint64_t> min_inclusion_price_;
+    if (min_inclusion_price.has_value()) {
+        min_inclusion_price_ = *min_inclusion_price;
+    }
+
+    std::vector<transaction> txs;
+    txs.reserve(rlptxs.size());
+    for (auto& rlptx : rlptxs) {
+        txs.emplace_back(std::move(rlptx));
+    }
+
+    // All transactions share the same EVM block context and are executed in order. If any of them
+    // fails validation the whole action is rejected.
+    process_txs(runtime_config{}, miner, txs, min_inclusion_price_);
 }
 
 void evm_contract::open(eosio::name owner) {
@@ -576,18 +675,7 @@ void evm_contract::open(eosio::name owner) {
 }
 
 void evm_contract::open_internal_balance(eosio::name owner) {
-    balances balance_table(get_self(), get_self().value);
-    if(balance_table.find(owner.value) == balance_table.end())
-        balance_table.emplace(owner, [&](balance& a) {
-            a.owner = owner;
-            a.balance.balance = eosio::asset(0, _config->get_token_symbol());
-        });
-
-    nextnonces nextnonce_table(get_self(), get_self().value);
-    if(nextnonce_table.find(owner.value) == nextnonce_table.end())
-        nextnonce_table.emplace(owner, [&](nextnonce& a) {
-            a.owner = owner;
-        });
+    _vaults->open(owner, _config->get_token_symbol());
 }
 
 void evm_contract::close(eosio::name owner) {
@@ -596,28 +684,11 @@ void evm_contract::close(eosio::name owner) {
 
     eosio::check(owner != get_self(), "Cannot close self");
 
-    balances balance_table(get_self(), get_self().value);
-    const balance& owner_account = balance_table.get(owner.value, "account is not open");
-
-    eosio::check(owner_account.balance.is_zero(), "cannot close because balance is not zero");
-    balance_table.erase(owner_account);
-
-    nextnonces nextnonce_table(get_self(), get_self().value);
-    const nextnonce& next_nonce_for_owner = nextnonce_table.get(owner.value);
-    //if the account has performed an EOS->EVM transfer the nonce needs to be maintained in case the account is re-opened in the future
-    if(next_nonce_for_owner.next_nonce == 0)
-        nextnonce_table.erase(next_nonce_for_owner);
+    _vaults->close(owner);
 }
 
 uint64_t evm_contract::get_and_increment_nonce(const name owner) {
-    nextnonces nextnonce_table(get_self(), get_self().value);
-
-    const nextnonce& nonce = nextnonce_table.get(owner.value, "caller account has not been opened");
-    uint64_t ret = nonce.next_nonce;
-    nextnonce_table.modify(nonce, eosio::same_payer, [](nextnonce& n){
-        ++n.next_nonce;
-    });
-    return ret;
+    return _vaults->get_and_increment_nonce(owner);
 }
 
 checksum256 evm_contract::get_code_hash(name account) const {
@@ -633,21 +704,15 @@ void evm_contract::handle_account_transfer(const eosio::asset& quantity, const s
     if(_config->get_evm_version() >= 1) _config->process_price_queue();
     eosio::name receiver(memo);
 
-    balances balance_table(get_self(), get_self().value);
-    const balance& receiver_account = balance_table.get(receiver.value, "receiving account has not been opened");
+    const vault& receiver_account = _vaults->get(receiver, "receiving account has not been opened");
 
-    balance_table.modify(receiver_account, eosio::same_payer, [&](balance& a) {
-        a.balance.balance += quantity;
-    });
+    _vaults->add(receiver_account, quantity);
 }
 
 void evm_contract::handle_evm_transfer(eosio::asset quantity, const std::string& memo) {
     if(_config->get_evm_version() >= 1) _config->process_price_queue();
     //move all incoming quantity in to the contract's balance. the evm bridge trx will "pull" from this balance
-    balances balance_table(get_self(), get_self().value);
-    balance_table.modify(balance_table.get(get_self().value), eosio::same_payer, [&](balance& b){
-        b.balance.balance += quantity;
-    });
+    _vaults->add(_vaults->get(get_self(), "account is not open"), quantity);
 
     //subtract off the ingress bridge fee from the quantity that will be bridged
     quantity -= _config->get_ingress_bridge_fee();
@@ -680,12 +745,13 @@ void evm_contract::handle_evm_transfer(eosio::asset quantity, const std::string&
 }
 
 void evm_contract::transfer(eosio::name from, eosio::name to, eosio::asset quantity, std::string memo) {
-    assert_unfrozen();
-    
-    // Allow transfer non-EOS tokens out.
+    // Allow transfer non-EOS tokens out. Checked first, so that notifications of transfers that
+    // are not deposits return without reading the config.
     if(to != get_self() || from == get_self())
         return;
 
+    assert_unfrozen();
+
     eosio::check(get_code() == _config->get_token_contract() && quantity.symbol == _config->get_token_symbol(), "received unexpected token");
 
     if(memo.size() == 42 && memo[0] == '0' && memo[1] == 'x')
@@ -700,11 +766,10 @@ void evm_contract::withdraw(eosio::name owner, eosio::asset quantity, const eosi
     assert_unfrozen();
     require_auth(owner);
 
-    balances balance_table(get_self(), get_self().value);
-    const balance& owner_account = balance_table.get(owner.value, "account is not open");
+    const vault& owner_account = _vaults->get(owner, "account is not open");
 
     check(owner_account.balance.balance.amount >= quantity.amount, "overdrawn balance");
-    balance_table.modify(owner_account, eosio::same_payer, [&](balance& a) {
+    _vaults->modify(owner_account, [&](vault& a) {
         a.balance.balance -= quantity;
     });
 
@@ -712,7 +777,7 @@ void evm_contract::withdraw(eosio::name owner, eosio::asset quantity, const eosi
     transfer_act.send(get_self(), to.has_value() ? *to : owner, quantity, std::string("Withdraw from EVM balance"));
 }
 
-bool evm_contract::gc(uint32_t max) {
+gc_result evm_contract::gc(uint32_t max) {
     assert_unfrozen();
     require_auth(get_self());
 
@@ -720,6 +785,55 @@ bool evm_contract::gc(uint32_t max) {
     return state.gc(max);
 }
 
+bool evm_contract::countgc(uint32_t max) {
+    assert_unfrozen();
+    require_auth(get_self());
+
+    evm_runtime::state state{get_self(), get_self()};
+    return state.count_gc(max);
+}
+
+gc_backlog evm_contract::gcbacklog(uint32_t max_entries, uint32_t max_rows) {
+    evm_runtime::state state{get_self(), get_self(), true};
+    return state.inspect_gc(max_entries, max_rows);
+}
+
+std::optional<storage_usage> evm_contract::storageusage(const bytes& address) {
+    evm_runtime::state state{get_self(), get_self(), true};
+    return state.read_storage_usage(to_address(address));
+}
+
+bool evm_contract::migratecode(uint32_t max) {
+    assert_unfrozen();
+    require_auth(get_self());
+
+    evm_runtime::state state{get_self(), get_self()};
+    return state.migrate_code(max);
+}
+
+bool evm_contract::migratestor(uint32_t max) {
+    assert_unfrozen();
+    require_auth(get_self());
+
+    evm_runtime::state state{get_self(), get_self()};
+    return state.migrate_storage(max);
+}
+
+bool evm_contract::migrateacct(uint32_t max) {
+    assert_unfrozen();
+    require_auth(get_self());
+
+    evm_runtime::state state{get_self(), get_self()};
+    return state.migrate_accounts(max);
+}
+
+bool evm_contract::migratevault(uint32_t max) {
+    assert_unfrozen();
+    require_auth(get_self());
+
+    return _vaults->migrate(max);
+}
+
 void evm_contract::call_(const runtime_config& rc, intx::uint256 s, const bytes& to, intx::uint256 value, const bytes& data, uint64_t gas_limit, uint64_t nonce) {
     if(_config->get_evm_version() >= 1) _config->process_price_queue();
 
@@ -743,13 +857,15 @@ void evm_contract::call_(const runtime_config& rc, intx::uint256 s, const bytes&
     dispatch_tx(rc, transaction{std::move(txn)});
 }
 
-void evm_contract::dispatch_tx(const runtime_config& rc, const transaction& tx) {
+void evm_contract::dispatch_tx(const runtime_config& rc, transaction tx) {
     if (_config->get_evm_version_and_maybe_promote() >= 1) {
-        process_tx(rc, get_self(), tx, {} /* min_inclusion_price */);
+        std::vector<transaction> txs;
+        txs.push_back(std::move(tx));
+        process_txs(rc, get_self(), txs, {} /* min_inclusion_price */);
     } else {
         eosio::check(rc.allow_special_signature && rc.abort_on_failure && !rc.enforce_chain_id && !rc.allow_non_self_miner, "invalid runtime config");
         action(permission_level{get_self(),"active"_n}, get_self(), "pushtx"_n,
-            std::tuple<eosio::name, bytes>(get_self(), tx.get_rlptx())
+            std::tuple<eosio::name, bytes>(get_self(), tx.release_rlptx())
         ).send();
     }
 }
@@ -851,15 +967,7 @@ void evm_contract::bridgeunreg(eosio::name receiver) {
 
 
 void evm_contract::assertnonce(eosio::name account, uint64_t next_nonce) { 
-    nextnonces nextnonce_table(get_self(), get_self().value);
-
-    auto next_nonce_iter = nextnonce_table.find(account.value);
-    if (next_nonce_iter == nextnonce_table.end()) {
-        eosio::check(0 == next_nonce, "wrong nonce");
-    }
-    else {
-        eosio::check(next_nonce_iter->next_nonce == next_nonce, "wrong nonce");
-    }
+    eosio::check(_vaults->get_next_nonce(account) == next_nonce, "wrong nonce");
 }
 
 void evm_contract::setversion(uint64_t version) {
@@ -885,4 +993,14 @@ void evm_contract::setgasparam(uint64_t gas_txnewaccount,
                                 gas_sset);
 }
 
+void evm_contract::setgcbudget(uint32_t max, uint32_t max_inline_slots) {
+    require_auth(get_self());
+    _config->set_gc_parameters(max, max_inline_slots);
+}
+
+void evm_contract::setevents(uint32_t flags) {
+    require_auth(get_self());
+    _config->set_event_flags(flags);
+}
+
 } //evm_runtime
@@ -1,74 +1,52 @@
 #include <eosio/system.hpp>
 #include <evm_runtime/evm_contract.hpp>
 #include <evm_runtime/tables.hpp>
+#include <evm_runtime/state.hpp>
+#include <evm_runtime/vault_wrapper.hpp>
 
 namespace evm_runtime {
 [[eosio::action]] void evm_contract::rmgcstore(uint64_t id) {
     eosio::require_auth(get_self());
-    gc_store_table gc(get_self(), get_self().value);
-    auto itr = gc.find(id);
-    eosio::check(itr != gc.end(), "gc row not found");
-    gc.erase(*itr);
+    evm_runtime::state{get_self(), get_self()}.remove_gc_entry(id);
 }
 
 [[eosio::action]] void evm_contract::setkvstore(uint64_t account_id, const bytes& key, const std::optional<bytes>& value) {
     eosio::require_auth(get_self());
     eosio::check(key.size() == 32 && (!value.has_value() || value.value().size() == 32), "invalid key/value size");
 
-    storage_table db(get_self(), account_id);
-    auto inx = db.get_index<"by.key"_n>();
-    auto itr = inx.find(make_key(key));
+    evm_runtime::state state{get_self(), get_self()};
+    const auto location = to_bytes32(key);
 
     if(value.has_value()) {
-        if(itr == inx.end()) {
-            db.emplace(get_self(), [&](auto& row){
-                row.id = db.available_primary_key();
-                row.key = key;
-                row.value = value.value();
-            });
-        } else {
-            db.modify(*itr, eosio::same_payer, [&](auto& row){
-                row.value = value.value();
-            });
-        }
+        state.write_slot(account_id, location, to_bytes32(value.value()));
     } else {
-        eosio::check(itr != inx.end(), "key not found");
-        db.erase(*itr);
+        eosio::check(!is_zero(state.read_slot(account_id, location)), "key not found");
+        state.write_slot(account_id, location, evmc::bytes32{});
     }
 }
 
 [[eosio::action]] void evm_contract::rmaccount(uint64_t id) {
     eosio::require_auth(get_self());
-    account_table accounts(get_self(), get_self().value);
-    auto itr = accounts.find(id);
-    eosio::check(itr != accounts.end(), "account not found");
-
-    if (itr->code_id) {
-        account_code_table codes(get_self(), get_self().value);
-        const auto& itrc = codes.get(itr->code_id.value(), "code not found");
-        if(itrc.ref_count-1) {
-            codes.modify(itrc, eosio::same_payer, [&](auto& row){
-                row.ref_count--;
-            });
-        } else {
-            codes.erase(itrc);
-        }
-    }
+    evm_runtime::state state{get_self(), get_self()};
+    state._max_inline_erase_slots = _config->get_max_inline_erase_slots();
+    state.migrate_account(id);
 
-    gc_store_table gc(get_self(), get_self().value);
-    gc.emplace(get_self(), [&](auto& row){
-        row.id = gc.available_primary_key();
-        row.storage_id = itr->id;
-    });
+    auto& accounts = state.accounts();
+    auto inx = accounts.get_index<"by.id"_n>();
+    auto itr = inx.find(id);
+    eosio::check(itr != inx.end(), "account not found");
 
-    accounts.erase(*itr);
+    state.remove_account(accounts.iterator_to(*itr));
 }
 
 [[eosio::action]] void evm_contract::addevmbal(uint64_t id, const bytes& delta, bool subtract) {
     eosio::require_auth(get_self());
-    account_table accounts(get_self(), get_self().value);
-    auto itr = accounts.find(id);
-    eosio::check(itr != accounts.end(), "account not found");
+    evm_runtime::state{get_self(), get_self()}.migrate_account(id);
+
+    account2_table accounts(get_self(), get_self().value);
+    auto inx = accounts.get_index<"by.id"_n>();
+    auto itr = inx.find(id);
+    eosio::check(itr != inx.end(), "account not found");
 
     inevm_singleton inevm(get_self(), get_self().value);
     auto d = to_uint256(delta);
@@ -76,28 +54,26 @@ namespace evm_runtime {
     intx::result_with_carry<intx::uint256> res;
     if(subtract) {
         inevm.set(inevm.get()-=d, eosio::same_payer);
-        res = intx::subc(to_uint256(itr->balance), d);
+        res = intx::subc(itr->get_balance(), d);
         eosio::check(!res.carry, "underflow detected");
     } else {
-        res = intx::addc(to_uint256(itr->balance), d);
+        res = intx::addc(itr->get_balance(), d);
         eosio::check(!res.carry, "overflow detected");
         inevm.set(inevm.get()+=d, eosio::same_payer);
     }
 
-    accounts.modify(*itr, eosio::same_payer, [&](auto& row){
-        row.balance = to_bytes(res.value);
+    inx.modify(itr, eosio::same_payer, [&](auto& row){
+        row.set_balance(res.value);
     });
 }
 
 [[eosio::action]] void evm_contract::addopenbal(name account, const bytes& delta, bool subtract) {
     eosio::require_auth(get_self());
-    balances open_balances(get_self(), get_self().value);
-    auto itr = open_balances.find(account.value);
-    eosio::check(itr != open_balances.end(), "account not found");
+    const vault& account_vault = _vaults->get(account, "account not found");
 
     auto d = to_uint256(delta);
 
-    open_balances.modify(*itr, eosio::same_payer, [&](auto& row){
+    _vaults->modify(account_vault, [&](auto& row){
         if(subtract) {
             row.balance-=d;
         } else {
@@ -108,11 +84,14 @@ namespace evm_runtime {
 
 [[eosio::action]] void evm_contract::freezeaccnt(uint64_t id, bool value) {
     eosio::require_auth(get_self());
-    account_table accounts(get_self(), get_self().value);
-    auto itr = accounts.find(id);
-    eosio::check(itr != accounts.end(), "account not found");
+    evm_runtime::state{get_self(), get_self()}.migrate_account(id);
+
+    account2_table accounts(get_self(), get_self().value);
+    auto inx = accounts.get_index<"by.id"_n>();
+    auto itr = inx.find(id);
+    eosio::check(itr != inx.end(), "account not found");
 
-    accounts.modify(*itr, eosio::same_payer, [&](auto& row){
+    inx.modify(itr, eosio::same_payer, [&](auto& row){
         if(value) {
             row.set_flag(account::flag::frozen);
         } else {
@@ -0,0 +1,77 @@
+#include <map>
+#include <memory>
+
+#include <evm_runtime/code_analysis.hpp>
+#include <evmone/baseline.hpp>
+
+namespace evm_runtime {
+
+namespace {
+
+struct registered_analysis {
+    size_t       code_size;
+    const bytes* jumpdests;
+};
+
+// Keyed by the address of the code buffer handed to silkworm by state::read_code
+std::map<const uint8_t*, registered_analysis> registered_analyses;
+
+constexpr uint8_t op_push1 = 0x60;
+constexpr uint8_t op_push32 = 0x7f;
+constexpr uint8_t op_jumpdest = 0x5b;
+
+} // namespace
+
+code_analysis analyze_code(ByteView code) {
+    code_analysis res{code_analysis_version, bytes((code.size() + 7) / 8, 0)};
+    for (size_t i = 0; i < code.size(); ++i) {
+        const auto op = code[i];
+        if (op >= op_push1 && op <= op_push32) {
+            i += op - (op_push1 - 1);
+        } else if (op == op_jumpdest) {
+            res.jumpdests[i / 8] |= static_cast<char>(1 << (i % 8));
+        }
+    }
+    return res;
+}
+
+void register_code_analysis(ByteView code, const bytes& jumpdests) {
+    registered_analyses[code.data()] = registered_analysis{code.size(), &jumpdests};
+}
+
+void unregister_code_analysis(ByteView code) {
+    registered_analyses.erase(code.data());
+}
+
+} // namespace evm_runtime
+
+namespace evmone::baseline {
+
+// evmone's implementation, renamed in src/CMakeLists.txt
+CodeAnalysis analyze_wasm(evmc_revision rev, bytes_view code);
+
+CodeAnalysis analyze(evmc_revision rev, bytes_view code) {
+    auto itr = evm_runtime::registered_analyses.find(code.data());
+    if (itr == evm_runtime::registered_analyses.end() || itr->second.code_size != code.size()) {
+        return analyze_wasm(rev, code);
+    }
+
+    const auto& jumpdests = *itr->second.jumpdests;
+    // Only the set bits need to be visited; the map is zero initialized a word at a time
+    CodeAnalysis::JumpdestMap map(code.size());
+    for (size_t b = 0; b < jumpdests.size(); ++b) {
+        for (auto bits = static_cast<uint8_t>(jumpdests[b]); bits != 0; bits &= bits - 1) {
+            map[b * 8 + __builtin_ctz(bits)] = true;
+        }
+    }
+
+    // Same padding as evmone: up to 32 bytes of PUSH data plus a terminating STOP
+    constexpr auto padding = 32 + 1;
+    std::unique_ptr<uint8_t[]> padded_code{new uint8_t[code.size() + padding]};
+    std::copy(code.begin(), code.end(), padded_code.get());
+    std::fill_n(&padded_code[code.size()], padding, uint8_t{0x00});
+
+    return {std::move(padded_code), code.size(), std::move(map)};
+}
+
+} // namespace evmone::baseline
@@ -4,7 +4,15 @@
 
 namespace evm_runtime {
 
-config_wrapper::config_wrapper(eosio::name self) : _self(self), _config(self, self.value) {
+config_wrapper::config_wrapper(eosio::name self) : _self(self), _config(self, self.value) {}
+
+config& config_wrapper::cached()const {
+    if(_loaded) {
+        return _cached_config;
+    }
+    // Loaded on first use, so actions that return before touching the config don't read it. The
+    // row is read as a whole: the hot paths need fields from both ends of it
+    _loaded = true;
     _exists = _config.exists();
     if(_exists) {
         _cached_config = _config.get();
@@ -17,6 +25,7 @@ config_wrapper::config_wrapper(eosio::name self) : _self(self), _config(self, se
         _cached_config.token_contract = default_token_account;
         // Don't set dirty because action can be read-only.
     }
+    return _cached_config;
 }
 
 config_wrapper::~config_wrapper() {
@@ -27,57 +36,62 @@ void config_wrapper::flush() {
     if(!is_dirty()) {
         return;
     }
-    _config.set(_cached_config, _self);
+    // Unset extensions are written with their default value, which would read as an empty queue
+    if(!cached().next_price_block.has_value()) {
+        load_next_price_block();
+    }
+    _config.set(cached(), _self);
     clear_dirty();
     _exists = true;
 }
 
 bool config_wrapper::exists() {
+    cached();
     return _exists;
 }
 
 eosio::unsigned_int config_wrapper::get_version()const { 
-    return _cached_config.version;
+    return cached().version;
 }
 
 void config_wrapper::set_version(const eosio::unsigned_int version) {
-    _cached_config.version = version;
+    cached().version = version;
     set_dirty();
 }
 
 uint64_t config_wrapper::get_chainid()const {
-    return _cached_config.chainid;
+    return cached().chainid;
 }
 
 void config_wrapper::set_chainid(uint64_t chainid) {
-    _cached_config.chainid = chainid;
+    cached().chainid = chainid;
     set_dirty();
 }
 
 const eosio::time_point_sec& config_wrapper::get_genesis_time()const {
-    return _cached_config.genesis_time;
+    return cached().genesis_time;
 }
 
 void config_wrapper::set_genesis_time(eosio::time_point_sec genesis_time) {
-    _cached_config.genesis_time = genesis_time;
+    cached().genesis_time = genesis_time;
     set_dirty();
 }
 
 const eosio::asset& config_wrapper::get_ingress_bridge_fee()const {
-    return _cached_config.ingress_bridge_fee;
+    return cached().ingress_bridge_fee;
 }
 
 void config_wrapper::set_ingress_bridge_fee(const eosio::asset& ingress_bridge_fee) {
-    _cached_config.ingress_bridge_fee = ingress_bridge_fee;
+    cached().ingress_bridge_fee = ingress_bridge_fee;
     set_dirty();
 }
 
 uint64_t config_wrapper::get_gas_price()const {
-    return _cached_config.gas_price;
+    return cached().gas_price;
 }
 
 void config_wrapper::set_gas_price(uint64_t gas_price) {
-    _cached_config.gas_price = gas_price;
+    cached().gas_price = gas_price;
     set_dirty();
 }
 
@@ -105,12 +119,21 @@ void config_wrapper::enqueue_gas_price(uint64_t gas_price) {
         el.price = gas_price;
     });
 
+    // The queue was empty, so the new entry is its front
+    if(cached().next_price_block.has_value() && *cached().next_price_block == 0) {
+        set_next_price_block(activation_block_num);
+    }
 }
 
 void config_wrapper::process_price_queue() {
     eosevm::block_mapping bm(get_genesis_time().sec_since_epoch());
     auto current_block_num = bm.timestamp_to_evm_block_num(get_current_time().time_since_epoch().count());
 
+    // Nothing is due yet, don't open the queue
+    if(cached().next_price_block.has_value() && (*cached().next_price_block == 0 || current_block_num < *cached().next_price_block)) {
+        return;
+    }
+
     price_queue_table queue(_self, _self.value);
     auto it = queue.begin();
     while( it != queue.end() && current_block_num >= it->block ) {
@@ -118,31 +141,46 @@ void config_wrapper::process_price_queue() {
         it = queue.erase(it);
     }
 
+    set_next_price_block(it != queue.end() ? it->block : 0);
+}
+
+void config_wrapper::set_next_price_block(uint64_t block_num) {
+    if(cached().next_price_block.has_value() && *cached().next_price_block == block_num) {
+        return;
+    }
+    cached().next_price_block = block_num;
+    set_dirty();
+}
+
+void config_wrapper::load_next_price_block() {
+    price_queue_table queue(_self, _self.value);
+    auto it = queue.begin();
+    cached().next_price_block = it != queue.end() ? it->block : 0;
 }
 
 uint32_t config_wrapper::get_miner_cut()const {
-    return _cached_config.miner_cut;
+    return cached().miner_cut;
 }
 
 void config_wrapper::set_miner_cut(uint32_t miner_cut) {
     eosio::check(miner_cut <= ninety_percent, "miner_cut must <= 90%");
-    _cached_config.miner_cut = miner_cut;
+    cached().miner_cut = miner_cut;
     set_dirty();
 }
 
 uint32_t config_wrapper::get_status()const {
-    return _cached_config.status;
+    return cached().status;
 }
 
 void config_wrapper::set_status(uint32_t status) {
-    _cached_config.status = status;
+    cached().status = status;
     set_dirty();
 }
 
 uint64_t config_wrapper::get_evm_version()const {
     uint64_t current_version = 0;
-    if(_cached_config.evm_version.has_value()) {
-        current_version = _cached_config.evm_version->get_version(_cached_config.genesis_time, get_current_time());
+    if(cached().evm_version.has_value()) {
+        current_version = cached().evm_version->get_version(cached().genesis_time, get_current_time());
     }
     return current_version;
 }
@@ -150,11 +188,11 @@ uint64_t config_wrapper::get_evm_version()const {
 uint64_t config_wrapper::get_evm_version_and_maybe_promote() {
     uint64_t current_version = 0;
     bool promoted = false;
-    if(_cached_config.evm_version.has_value()) {
-        std::tie(current_version, promoted) = _cached_config.evm_version->get_version_and_maybe_promote(_cached_config.genesis_time, get_current_time());
+    if(cached().evm_version.has_value()) {
+        std::tie(current_version, promoted) = cached().evm_version->get_version_and_maybe_promote(cached().genesis_time, get_current_time());
     }
     if(promoted) {
-        if(current_version >=1 && _cached_config.miner_cut != 0) _cached_config.miner_cut = 0;
+        if(current_version >=1 && cached().miner_cut != 0) cached().miner_cut = 0;
         set_dirty();
     }
     return current_version;
@@ -164,7 +202,7 @@ void config_wrapper::set_evm_version(uint64_t new_version) {
     eosio::check(new_version <= eosevm::max_eos_evm_version, "Unsupported version");
     auto current_version = get_evm_version_and_maybe_promote();
     eosio::check(new_version > current_version, "new version must be greater than the active one");
-    _cached_config.evm_version.emplace(evm_version_type{evm_version_type::pending{new_version, get_current_time()}, current_version});
+    cached().evm_version.emplace(evm_version_type{evm_version_type::pending{new_version, get_current_time()}, current_version});
     set_dirty();
 }
 
@@ -185,18 +223,18 @@ void config_wrapper::set_fee_parameters(const fee_parameters& fee_params,
     if (fee_params.miner_cut.has_value()) {
         eosio::check(get_evm_version() == 0, "can't set miner_cut");
         eosio::check(*fee_params.miner_cut <= ninety_percent, "miner_cut must <= 90%");
-        _cached_config.miner_cut = *fee_params.miner_cut;
+        cached().miner_cut = *fee_params.miner_cut;
     } else {
         eosio::check(allow_any_to_be_unspecified, "All required fee parameters not specified: missing miner_cut");
     }
 
     if (fee_params.ingress_bridge_fee.has_value()) {
-        if (_cached_config.ingress_bridge_fee.symbol != eosio::symbol()) {
-            eosio::check(fee_params.ingress_bridge_fee->symbol == _cached_config.ingress_bridge_fee.symbol, "bridge symbol can't change");
+        if (cached().ingress_bridge_fee.symbol != eosio::symbol()) {
+            eosio::check(fee_params.ingress_bridge_fee->symbol == cached().ingress_bridge_fee.symbol, "bridge symbol can't change");
         }
         eosio::check(fee_params.ingress_bridge_fee->amount >= 0, "ingress bridge fee cannot be negative");
 
-        _cached_config.ingress_bridge_fee = *fee_params.ingress_bridge_fee;
+        cached().ingress_bridge_fee = *fee_params.ingress_bridge_fee;
     } else {
         eosio::check(allow_any_to_be_unspecified, "All required fee parameters not specified: missing ingress_bridge_fee");
     }
@@ -209,7 +247,7 @@ void config_wrapper::update_consensus_parameters(eosio::asset ram_price_mb, uint
     eosio::check(ram_price_mb.symbol == get_token_symbol(), "invalid price symbol");
     eosio::check(gas_price >= one_gwei, "gas_price must >= 1Gwei");
 
-    auto miner_cut = get_evm_version() >= 1 ? 0 : _cached_config.miner_cut;
+    auto miner_cut = get_evm_version() >= 1 ? 0 : cached().miner_cut;
     double gas_per_byte_f = (ram_price_mb.amount / (1024.0 * 1024.0) * get_minimum_natively_representable()) / (gas_price * static_cast<double>(hundred_percent - miner_cut) / hundred_percent);
 
     constexpr uint64_t account_bytes = 347;
@@ -242,9 +280,9 @@ void config_wrapper::update_consensus_parameters2(std::optional<uint64_t> gas_tx
     eosio::check(get_evm_version() >= 1, "evm_version must >= 1");
 
     // should not happen
-    eosio::check(_cached_config.consensus_parameter.has_value(), "consensus_parameter not exist");
+    eosio::check(cached().consensus_parameter.has_value(), "consensus_parameter not exist");
 
-    _cached_config.consensus_parameter->update_consensus_param([&](auto & v) {
+    cached().consensus_parameter->update_consensus_param([&](auto & v) {
         if (gas_txnewaccount.has_value()) v.gas_parameter.gas_txnewaccount = *gas_txnewaccount;
         if (gas_newaccount.has_value()) v.gas_parameter.gas_newaccount = *gas_newaccount;
         if (gas_txcreate.has_value()) v.gas_parameter.gas_txcreate = *gas_txcreate;
@@ -260,16 +298,16 @@ void config_wrapper::update_consensus_parameters2(std::optional<uint64_t> gas_tx
 
 const consensus_parameter_data_type& config_wrapper::get_consensus_param() {
     // should not happen
-    eosio::check(_cached_config.consensus_parameter.has_value(), "consensus_parameter not exist");
-    return _cached_config.consensus_parameter->get_consensus_param(_cached_config.genesis_time, get_current_time());
+    eosio::check(cached().consensus_parameter.has_value(), "consensus_parameter not exist");
+    return cached().consensus_parameter->get_consensus_param(cached().genesis_time, get_current_time());
 }
 
 std::pair<const consensus_parameter_data_type &, bool> config_wrapper::get_consensus_param_and_maybe_promote() {
 
     // should not happen
-    eosio::check(_cached_config.consensus_parameter.has_value(), "consensus_parameter not exist");
+    eosio::check(cached().consensus_parameter.has_value(), "consensus_parameter not exist");
 
-    auto pair = _cached_config.consensus_parameter->get_consensus_param_and_maybe_promote(_cached_config.genesis_time, get_current_time());
+    auto pair = cached().consensus_parameter->get_consensus_param_and_maybe_promote(cached().genesis_time, get_current_time());
     if (pair.second) {
         set_dirty();
     }
@@ -297,19 +335,42 @@ time_point config_wrapper::get_current_time()const {
 }
 
 void config_wrapper::set_token_contract(eosio::name token_contract) {
-    _cached_config.token_contract = token_contract;
+    cached().token_contract = token_contract;
 }
 
 eosio::name config_wrapper::get_token_contract() const {
-    return *_cached_config.token_contract;
+    return *cached().token_contract;
 }
 
 eosio::symbol config_wrapper::get_token_symbol() const {
-    return _cached_config.ingress_bridge_fee.symbol;
+    return cached().ingress_bridge_fee.symbol;
 }
 
 uint64_t config_wrapper::get_minimum_natively_representable() const {
-    return pow10_const(evm_precision - _cached_config.ingress_bridge_fee.symbol.precision());
+    return pow10_const(evm_precision - cached().ingress_bridge_fee.symbol.precision());
+}
+
+uint32_t config_wrapper::get_gc_budget() const {
+    return cached().gc_budget.value_or(0);
+}
+
+uint32_t config_wrapper::get_max_inline_erase_slots() const {
+    return cached().max_inline_erase_slots.value_or(0);
+}
+
+void config_wrapper::set_gc_parameters(uint32_t gc_budget, uint32_t max_inline_erase_slots) {
+    cached().gc_budget = gc_budget;
+    cached().max_inline_erase_slots = max_inline_erase_slots;
+    set_dirty();
+}
+
+uint32_t config_wrapper::get_event_flags() const {
+    return cached().event_flags.value_or(0);
+}
+
+void config_wrapper::set_event_flags(uint32_t event_flags) {
+    cached().event_flags = event_flags;
+    set_dirty();
 }
 
 } //namespace evm_runtime
\ No newline at end of file
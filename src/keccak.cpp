@@ -0,0 +1,20 @@
+#include <ethash/keccak.h>
+#include <evm_runtime/intrinsics.hpp>
+
+// Replaces the keccak256 entry points of ethash with the host `sha3` intrinsic.
+// Every keccak256 computed by silkworm and evmone (SHA3 opcode, CREATE/CREATE2
+// addresses, code hashes, sender addresses) goes through these two functions.
+
+extern "C" {
+
+union ethash_hash256 ethash_keccak256(const uint8_t* data, size_t size) noexcept {
+    union ethash_hash256 hash;
+    eosio::internal_use_do_not_use::sha3(reinterpret_cast<const char*>(data), size, reinterpret_cast<char*>(hash.bytes), sizeof(hash.bytes), 1);
+    return hash;
+}
+
+union ethash_hash256 ethash_keccak256_32(const uint8_t data[32]) noexcept {
+    return ethash_keccak256(data, 32);
+}
+
+}
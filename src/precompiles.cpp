@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include <eosio/crypto.hpp>
+#include <silkworm/core/execution/precompile.hpp>
+#include <silkworm/core/common/endian.hpp>
+#include <evm_runtime/intrinsics.hpp>
+
+// Host function backed implementations of silkworm precompiles.
+// kContracts (precompile.hpp) binds to these symbols; the WASM versions
+// in precompile.cpp are compiled under a different name (see src/CMakeLists.txt).
+
+namespace silkworm::precompile {
+
+namespace {
+
+// Copy of `input` zero padded (or truncated) to exactly `size` bytes
+Bytes padded(ByteView input, size_t size) {
+    Bytes out(size, 0);
+    std::memcpy(out.data(), input.data(), std::min(input.size(), size));
+    return out;
+}
+
+const char* as_chars(const Bytes& b) { return reinterpret_cast<const char*>(b.data()); }
+const char* as_chars(ByteView b) { return reinterpret_cast<const char*>(b.data()); }
+
+// Reads a 32 byte big endian length; anything that doesn't fit in 32 bits
+// would have been rejected by the gas function already.
+std::optional<uint32_t> read_length(ByteView word) {
+    const auto len = intx::be::unsafe::load<intx::uint256>(word.data());
+    if (len > std::numeric_limits<uint32_t>::max()) {
+        return std::nullopt;
+    }
+    return static_cast<uint32_t>(len);
+}
+
+constexpr size_t kBlake2fInputSize = 213;
+
+constexpr size_t kG1Size = 64;
+constexpr size_t kG2Size = 128;
+constexpr size_t kScalarSize = 32;
+
+} // namespace
+
+std::optional<Bytes> sha256_run(ByteView input) noexcept {
+    const auto hash = eosio::sha256(as_chars(input), input.size()).extract_as_byte_array();
+    return Bytes{hash.begin(), hash.end()};
+}
+
+std::optional<Bytes> rip160_run(ByteView input) noexcept {
+    const auto hash = eosio::ripemd160(as_chars(input), input.size()).extract_as_byte_array();
+    Bytes out(32, 0);
+    std::memcpy(out.data() + 12, hash.data(), hash.size());
+    return out;
+}
+
+std::optional<Bytes> expmod_run(ByteView input) noexcept {
+    const Bytes header = padded(input, 3 * 32);
+    const auto base_len = read_length(ByteView{header}.substr(0, 32));
+    const auto exp_len = read_length(ByteView{header}.substr(32, 32));
+    const auto mod_len = read_length(ByteView{header}.substr(64, 32));
+    if (!base_len || !exp_len || !mod_len) {
+        return std::nullopt;
+    }
+
+    if (*mod_len == 0) {
+        return Bytes{};
+    }
+
+    input = input.size() > header.size() ? input.substr(header.size()) : ByteView{};
+    const Bytes args = padded(input, size_t{*base_len} + *exp_len + *mod_len);
+    const char* base = as_chars(args);
+    const char* exp = base + *base_len;
+    const char* mod = exp + *exp_len;
+
+    Bytes out(*mod_len, 0);
+
+    // x mod 0 is defined as 0
+    if (std::all_of(mod, mod + *mod_len, [](char c) { return c == 0; })) {
+        return out;
+    }
+
+    if (eosio::internal_use_do_not_use::mod_exp(base, *base_len, exp, *exp_len, mod, *mod_len,
+                                                reinterpret_cast<char*>(out.data()), out.size()) != 0) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+std::optional<Bytes> bn_add_run(ByteView input) noexcept {
+    const Bytes in = padded(input, 2 * kG1Size);
+    Bytes out(kG1Size, 0);
+    if (eosio::internal_use_do_not_use::alt_bn128_add(as_chars(in), kG1Size, as_chars(in) + kG1Size, kG1Size,
+                                                      reinterpret_cast<char*>(out.data()), out.size()) != 0) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+std::optional<Bytes> bn_mul_run(ByteView input) noexcept {
+    const Bytes in = padded(input, kG1Size + kScalarSize);
+    Bytes out(kG1Size, 0);
+    if (eosio::internal_use_do_not_use::alt_bn128_mul(as_chars(in), kG1Size, as_chars(in) + kG1Size, kScalarSize,
+                                                      reinterpret_cast<char*>(out.data()), out.size()) != 0) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+std::optional<Bytes> snarkv_run(ByteView input) noexcept {
+    if (input.size() % (kG1Size + kG2Size) != 0) {
+        return std::nullopt;
+    }
+
+    Bytes out(32, 0);
+    if (input.empty()) {
+        out[31] = 1;
+        return out;
+    }
+
+    // 0: pairing holds, 1: pairing does not hold, -1: invalid input
+    const int32_t res = eosio::internal_use_do_not_use::alt_bn128_pair(as_chars(input), input.size());
+    if (res < 0) {
+        return std::nullopt;
+    }
+    out[31] = res == 0 ? 1 : 0;
+    return out;
+}
+
+std::optional<Bytes> blake2_f_run(ByteView input) noexcept {
+    if (input.size() != kBlake2fInputSize) {
+        return std::nullopt;
+    }
+
+    // rounds (4, big endian) | h (64) | m (128) | t0 (8) | t1 (8) | f (1)
+    const uint32_t rounds = endian::load_big_u32(input.data());
+    const uint8_t f = input[212];
+    if (f > 1) {
+        return std::nullopt;
+    }
+
+    const char* in = as_chars(input);
+    Bytes out(64, 0);
+    if (eosio::internal_use_do_not_use::blake2_f(rounds, in + 4, 64, in + 68, 128, in + 196, 8, in + 204, 8, f,
+                                                 reinterpret_cast<char*>(out.data()), out.size()) != 0) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+} // namespace silkworm::precompile
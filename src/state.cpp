@@ -1,19 +1,266 @@
 #include <map>
+#include <algorithm>
 #include <evm_runtime/tables.hpp>
 #include <evm_runtime/state.hpp>
 #include <ethash/keccak.hpp>
 #include <silkworm/core/common/util.hpp>
+#include <silkworm/core/common/endian.hpp>
 #include <evm_runtime/intrinsics.hpp>
 
 namespace evm_runtime {
 
-std::optional<Account> state::read_account(const evmc::address& address) const noexcept {    
-    account_table accounts(_self, _self.value);
-    auto inx = accounts.get_index<"by.address"_n>();
+namespace {
+
+// Home id of a slot in `storage2`, hashed like account_key so that crafted slots can't pile up on one id
+uint64_t slot_id(const evmc::bytes32& location) {
+    const auto hash = ethash::keccak256(location.bytes, sizeof(location.bytes));
+    return silkworm::endian::load_big_u64(hash.bytes);
+}
+
+// Hashed ids only collide by chance, a longer chain means the table is broken or under attack
+constexpr uint64_t max_slot_probe = 64;
+
+evmc::bytes32 to_bytes32(const checksum256& data) {
+    evmc::bytes32 res;
+    const auto arr = data.extract_as_byte_array();
+    std::copy(arr.begin(), arr.end(), res.bytes);
+    return res;
+}
+
+// serialized size of a `storage2` row, it varies with the length of its key and value
+int64_t row_size(const storage2& row) {
+    return eosio::pack_size(row);
+}
+
+// Home key of an address in `account2`, hashed so that crafted addresses can't pile up on one key
+uint64_t account_key(const evmc::address& address) {
+    const auto hash = ethash::keccak256(address.bytes, sizeof(address.bytes));
+    return silkworm::endian::load_big_u64(hash.bytes);
+}
+
+account2 to_account2(const account& legacy) {
+    account2 row;
+    row.id = legacy.id;
+    row.set_address(to_address(legacy.eth_address));
+    row.nonce = legacy.nonce;
+    row.set_balance(intx::be::load<uint256>(legacy.get_balance()));
+    row.code_id = legacy.code_id;
+    row.flags = legacy.flags.value();
+    return row;
+}
+
+} // namespace
+
+account2_table& state::accounts() const {
+    if (!_accounts) {
+        _accounts.emplace(_self, _self.value);
+    }
+    return *_accounts;
+}
+
+storage2_table& state::storage2(uint64_t account_id) const {
+    return _storages.try_emplace(account_id, _self, account_id).first->second;
+}
+
+state::account_probe state::probe_account(const evmc::address& address) const {
+    auto cached = addr2probe.find(address);
+    if (cached != addr2probe.end()) {
+        ++stats.account.cached;
+        return cached->second;
+    }
+
+    auto& db = accounts();
+    const checksum160 eth_address{address.bytes};
+    for (uint64_t key = account_key(address);; ++key) {
+        auto itr = db.find(key);
+        ++stats.account.read;
+        if (itr == db.end() || itr->eth_address == eth_address) {
+            return addr2probe[address] = account_probe{itr, key};
+        }
+    }
+}
+
+bool state::has_legacy_accounts() const {
+    if (!legacy_accounts) {
+        account_table legacy(_self, _self.value);
+        legacy_accounts = legacy.begin() != legacy.end();
+    }
+    return *legacy_accounts;
+}
+
+std::optional<account2> state::find_legacy_account(const evmc::address& address) const {
+    if (!has_legacy_accounts()) return {};
+
+    account_table legacy(_self, _self.value);
+    auto inx = legacy.get_index<"by.address"_n>();
+    auto itr = inx.find(make_key(address));
+    ++stats.account.read;
+    if (itr == inx.end()) return {};
+    return to_account2(*itr);
+}
+
+state::account_probe state::load_account(const evmc::address& address) {
+    auto probe = probe_account(address);
+    if (probe.row != accounts().end() || !has_legacy_accounts()) {
+        return probe;
+    }
+
+    account_table legacy(_self, _self.value);
+    auto inx = legacy.get_index<"by.address"_n>();
     auto itr = inx.find(make_key(address));
     ++stats.account.read;
+    if (itr != inx.end()) {
+        probe.row = migrate_account_row(legacy, legacy.iterator_to(*itr), probe.key);
+    }
+    return probe;
+}
+
+account2_table::const_iterator state::migrate_account_row(account_table& legacy, account_table::const_iterator itr, uint64_t key) {
+    // the next account id is derived from the legacy table until it has been stored once
+    load_config2();
+    auto row = to_account2(*itr);
+    row.key = key;
+    legacy.erase(itr);
+    return emplace_account(row);
+}
 
-    if (itr == inx.end()) {
+account2_table::const_iterator state::create_account(uint64_t key, const evmc::address& address,
+                                                     uint64_t nonce, const uint256& balance) {
+    account2 row;
+    row.key = key;
+    row.id = get_next_account_id();
+    row.set_address(address);
+    row.nonce = nonce;
+    row.set_balance(balance);
+    row.usage.emplace();
+    return emplace_account(row);
+}
+
+account2_table::const_iterator state::emplace_account(const account2& row) {
+    auto& db = accounts();
+    // lookups that stopped at this key have to go on past it now
+    for (auto itr = addr2probe.begin(); itr != addr2probe.end();) {
+        if (itr->second.key == row.key && itr->second.row == db.end()) {
+            itr = addr2probe.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+    auto itr = db.emplace(_ram_payer, [&](auto& r){ r = row; });
+    addr2probe[row.get_address()] = {itr, row.key};
+    absent_accounts.erase(row.get_address());
+    return itr;
+}
+
+void state::migrate_account(uint64_t id) {
+    check(!_read_only, "ro state");
+    if (!has_legacy_accounts()) return;
+
+    account_table legacy(_self, _self.value);
+    auto itr = legacy.find(id);
+    if (itr == legacy.end()) return;
+
+    auto probe = probe_account(to_address(itr->eth_address));
+    check(probe.row == accounts().end(), "account already migrated");
+    migrate_account_row(legacy, itr, probe.key);
+}
+
+bool state::migrate_accounts(uint32_t max) {
+    check(!_read_only, "ro state");
+    account_table legacy(_self, _self.value);
+    auto itr = legacy.begin();
+    while( max && itr != legacy.end() ) {
+        auto probe = probe_account(to_address(itr->eth_address));
+        check(probe.row == accounts().end(), "account already migrated");
+        migrate_account_row(legacy, itr, probe.key);
+        itr = legacy.begin();
+        --max;
+    }
+    legacy_accounts = itr != legacy.end();
+    return !*legacy_accounts;
+}
+
+void state::remove_account(account2_table::const_iterator itr) {
+    check(!_read_only, "ro state");
+    retire_account(itr);
+
+    // Rows further down the probe chain are moved back into the hole, so that a missing key
+    // always ends a lookup. The contents move and the rows stay where they are, so each row
+    // keeps its payer and only the last one of the shift is erased.
+    auto& db = accounts();
+    auto hole = itr;
+    for (uint64_t key = hole->key + 1;; ++key) {
+        auto next = db.find(key);
+        if (next == db.end()) break;
+        if (key - account_key(next->get_address()) < key - hole->key) continue;
+
+        db.modify(hole, eosio::same_payer, [&](auto& r){
+            const uint64_t at = r.key;
+            r = *next;
+            r.key = at;
+        });
+        hole = next;
+    }
+    db.erase(hole);
+    // cached probes may point at rows that were erased or moved
+    addr2probe.clear();
+}
+
+void state::retire_account(account2_table::const_iterator itr) {
+    const uint64_t account_id = itr->id;
+    std::optional<int64_t> slots;
+    if (itr->usage.has_value() && !has_legacy_storage(account_id)) {
+        slots = itr->usage.value().slots + usage_deltas[account_id].slots;
+    }
+    usage_deltas.erase(account_id);
+
+    if (_max_inline_erase_slots && slots && *slots <= _max_inline_erase_slots) {
+        auto& db = storage2(account_id);
+        for (auto sitr = db.begin(); sitr != db.end();) {
+            sitr = db.erase(sitr);
+        }
+        forget_slots(account_id, false);
+    } else {
+        // add to garbage collection table for later removal
+        auto progress = load_gc_progress();
+        gc_store_table gc(_self, _self.value);
+        const uint64_t id = gc.available_primary_key();
+        gc.emplace(_ram_payer, [&](auto& row){
+            row.id = id;
+            row.storage_id = account_id;
+        });
+        if (progress.is_counted(id)) {
+            ++progress.entries;
+            gc_progress_singleton(_self, _self.value).set(progress, _self);
+        }
+    }
+    // Remove code if necessary
+    if (itr->code_id) {
+        release_code(itr->code_id.value());
+    }
+    addr2id.erase(itr->get_address());
+    // the storage is collected as a whole, buffered writes to it are moot
+    pending_slots.erase(pending_slots.lower_bound(slot_write{account_id, 0, evmc::bytes32{}}),
+                        pending_slots.lower_bound(slot_write{account_id + 1, 0, evmc::bytes32{}}));
+}
+
+std::optional<Account> state::read_account(const evmc::address& address) const noexcept {    
+    if (absent_accounts.count(address)) {
+        ++stats.account.absent;
+        return {};
+    }
+
+    auto probe = probe_account(address);
+
+    std::optional<account2> legacy;
+    const account2* itr = nullptr;
+    if (probe.row != accounts().end()) {
+        itr = &*probe.row;
+    } else if ((legacy = find_legacy_account(address))) {
+        itr = &*legacy;
+    } else {
+        absent_accounts.insert(address);
+        ++stats.account.missing;
         return {};
     }
     eosio::check(_allow_frozen || !itr->has_flag(account::flag::frozen), "account is frozen");
@@ -22,21 +269,27 @@ std::optional<Account> state::read_account(const evmc::address& address) const n
 
     evmc::bytes32 code_hash;
     if (itr->code_id) {
-        account_code_table codes(_self, _self.value);
-        auto citr = codes.find(itr->code_id.value());
-        if (citr != codes.end()) {
-            code_hash = to_bytes32(citr->code_hash);
-            addr2code[code_hash] = citr->code;
+        code_meta_table metas(_self, _self.value);
+        auto mitr = metas.find(itr->code_id.value());
+        if (mitr != metas.end()) {
+            code_hash = mitr->get_code_hash();
         } else {
-            // Should not reach here! 
-            // Return empty hash for robustness.
-            code_hash = silkworm::kEmptyHash;
+            account_code_table codes(_self, _self.value);
+            auto citr = codes.find(itr->code_id.value());
+            if (citr != codes.end()) {
+                code_hash = to_bytes32(citr->code_hash);
+                cache_code(code_hash, citr->code, nullptr);
+            } else {
+                // Should not reach here! 
+                // Return empty hash for robustness.
+                code_hash = silkworm::kEmptyHash;
+            }
         }
     } else {
         code_hash = silkworm::kEmptyHash;
     }
 
-    return Account{itr->nonce, intx::be::load<uint256>(itr->get_balance()), code_hash, 0};
+    return Account{itr->nonce, itr->get_balance(), code_hash, 0};
 }
 
 ByteView state::read_code(const evmc::bytes32& code_hash) const noexcept {
@@ -46,6 +299,18 @@ ByteView state::read_code(const evmc::bytes32& code_hash) const noexcept {
         return ByteView{(const uint8_t*)code.data(), code.size()};
     }
     
+    code_meta_table metas(_self, _self.value);
+    auto minx = metas.get_index<"by.codehash"_n>();
+    auto mitr = minx.find(make_key(code_hash));
+    if (mitr != minx.end()) {
+        code_blob_table blobs(_self, _self.value);
+        auto bitr = blobs.find(mitr->id);
+        if (bitr == blobs.end() || bitr->code.size() == 0) {
+            return ByteView{};
+        }
+        return cache_code(code_hash, bitr->code, &bitr->analysis);
+    }
+
     account_code_table codes(_self, _self.value);
     auto inx = codes.get_index<"by.codehash"_n>();
     auto itr = inx.find(make_key(code_hash));
@@ -54,39 +319,293 @@ ByteView state::read_code(const evmc::bytes32& code_hash) const noexcept {
         return ByteView{};
     }
 
-    addr2code[code_hash] = itr->code;
-    const auto& code = addr2code[code_hash];
-    return ByteView{(const uint8_t*)code.data(), code.size()};
+    return cache_code(code_hash, itr->code, nullptr);
+}
+
+ByteView state::cache_code(const bytes32& code_hash, const bytes& code, const code_analysis* analysis) const {
+    auto& cached = addr2code[code_hash];
+    unregister_code_analysis(ByteView{(const uint8_t*)cached.data(), cached.size()});
+    cached = code;
+
+    ByteView view{(const uint8_t*)cached.data(), cached.size()};
+    if (analysis && analysis->is_valid_for(view)) {
+        const auto& jumpdests = code2jumpdests[code_hash] = analysis->jumpdests;
+        register_code_analysis(view, jumpdests);
+    }
+    return view;
 }
 
 evmc::bytes32 state::read_storage(const evmc::address& address, uint64_t incarnation,
                                           const evmc::bytes32& location) const noexcept {
-    
-    uint64_t account_id = 0;
-    if(addr2id.find(address) == addr2id.end()) {
-        account_table accounts(_self, _self.value);
-        auto inx = accounts.get_index<"by.address"_n>();
-        auto itr = inx.find(make_key(address));
-        ++stats.account.read;
-        if (itr == inx.end()) return {};
-        addr2id[address] = itr->id;
+    auto account_id = find_account_id(address);
+    if (!account_id) return {};
+    return read_slot(*account_id, location);
+}
+
+std::optional<uint64_t> state::find_account_id(const evmc::address& address) const {
+    auto cached = addr2id.find(address);
+    if (cached != addr2id.end()) return cached->second;
+
+    if (absent_accounts.count(address)) {
+        ++stats.account.absent;
+        return {};
     }
+    auto probe = probe_account(address);
+    if (probe.row != accounts().end()) {
+        return addr2id[address] = probe.row->id;
+    } else if (auto legacy = find_legacy_account(address)) {
+        return addr2id[address] = legacy->id;
+    }
+    absent_accounts.insert(address);
+    ++stats.account.missing;
+    return {};
+}
 
-    account_id = addr2id[address];
+void state::warm_up(const std::vector<AccessListEntry>& access_list) const {
+    // accounts in the order of their keys in `account2`, then slots by account and slot id, so
+    // that each table is walked once in row order
+    std::vector<std::pair<uint64_t, const AccessListEntry*>> entries;
+    entries.reserve(access_list.size());
+    for (const auto& entry : access_list) {
+        entries.emplace_back(account_key(entry.account), &entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
 
-    storage_table db(_self, account_id);
-    auto inx2 = db.get_index<"by.key"_n>();
-    auto itr2 = inx2.find(make_key(location));
-    ++stats.storage.read;
-    
-    if(itr2 == inx2.end()) return {};
+    std::vector<slot_write> slots;
+    for (const auto& [key, entry] : entries) {
+        auto account_id = find_account_id(entry->account);
+        if (!account_id) continue;
+        for (const auto& location : entry->storage_keys) {
+            slots.emplace_back(*account_id, slot_id(location), location);
+        }
+    }
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
 
-    evmc::bytes32 res;
-    std::copy(itr2->value.begin(), itr2->value.end(), res.bytes);
+    for (const auto& [account_id, id, location] : slots) {
+        read_slot(account_id, location);
+    }
+}
 
-    return res;
+bool state::has_legacy_storage(uint64_t account_id) const {
+    auto itr = legacy_storage.find(account_id);
+    if (itr == legacy_storage.end()) {
+        storage_table db(_self, account_id);
+        itr = legacy_storage.emplace(account_id, db.begin() != db.end()).first;
+    }
+    return itr->second;
+}
+
+state::slot_probe state::probe_slot(uint64_t account_id, const evmc::bytes32& location) const {
+    auto cached = slot2probe.find({account_id, location});
+    if (cached != slot2probe.end()) {
+        ++stats.storage.cached;
+        return cached->second;
+    }
+
+    const auto& db = storage2(account_id);
+    const auto key = to_compact_bytes(location);
+    std::optional<uint64_t> free;
+    for (uint64_t id = slot_id(location);; ++id) {
+        auto itr = db.find(id);
+        if (itr == db.end() || itr->key == key) {
+            ++stats.storage.read;
+            return slot2probe[{account_id, location}] = slot_probe{itr, free.value_or(id)};
+        }
+        if (!free && itr->is_free()) {
+            free = id;
+        }
+    }
+}
+
+void state::forget_slots(uint64_t account_id, bool misses_only) {
+    const auto& db = storage2(account_id);
+    auto itr = slot2probe.lower_bound({account_id, evmc::bytes32{}});
+    while (itr != slot2probe.end() && itr->first.first == account_id) {
+        if (!misses_only || itr->second.row == db.end()) {
+            itr = slot2probe.erase(itr);
+        } else {
+            ++itr;
+        }
+    }
+}
+
+evmc::bytes32 state::read_slot(uint64_t account_id, const evmc::bytes32& location) const {
+    auto pending = pending_slots.find(slot_write{account_id, slot_id(location), location});
+    if (pending != pending_slots.end()) {
+        ++stats.storage.cached;
+        return pending->second;
+    }
+    if (absent_slots.count({account_id, location})) {
+        ++stats.storage.absent;
+        return {};
+    }
+
+    auto probe = probe_slot(account_id, location);
+    if (probe.row != storage2(account_id).end()) {
+        return from_compact_bytes(probe.row->value);
+    }
+
+    if (has_legacy_storage(account_id)) {
+        storage_table legacy(_self, account_id);
+        auto inx = legacy.get_index<"by.key"_n>();
+        auto itr = inx.find(make_key(location));
+        ++stats.storage.read;
+        if (itr != inx.end()) {
+            evmc::bytes32 res;
+            std::copy(itr->value.begin(), itr->value.end(), res.bytes);
+            return res;
+        }
+    }
+
+    absent_slots.emplace(account_id, location);
+    ++stats.storage.missing;
+    return {};
+}
+
+void state::write_slot(uint64_t account_id, const evmc::bytes32& location, const evmc::bytes32& value) {
+    check(!_read_only, "ro state");
+    pending_slots.erase(slot_write{account_id, slot_id(location), location});
+    absent_slots.erase({account_id, location});
+    if (has_legacy_storage(account_id)) {
+        storage_table legacy(_self, account_id);
+        auto inx = legacy.get_index<"by.key"_n>();
+        auto itr = inx.find(make_key(location));
+        if (itr != inx.end()) {
+            legacy.erase(*itr);
+        }
+    }
+    store_slot(account_id, location, value);
 }
 
+void state::flush() {
+    // ordered by account id and then by slot id, so each scope is visited once and its rows in order
+    auto pending = std::move(pending_slots);
+    pending_slots.clear();
+    for (const auto& [write, value] : pending) {
+        const auto& [account_id, id, location] = write;
+        write_slot(account_id, location, value);
+    }
+    apply_usage_deltas();
+}
+
+void state::apply_usage_deltas() {
+    auto inx = accounts().get_index<"by.id"_n>();
+    for (const auto& [account_id, delta] : usage_deltas) {
+        if (!delta.slots && !delta.bytes) continue;
+        auto itr = inx.find(account_id);
+        // not moved from `account` yet or moved without a known usage
+        if (itr == inx.end() || !itr->usage.has_value()) continue;
+        inx.modify(itr, eosio::same_payer, [&](auto& row){
+            row.usage.value().slots += delta.slots;
+            row.usage.value().bytes += delta.bytes;
+        });
+    }
+    usage_deltas.clear();
+}
+
+std::optional<storage_usage> state::read_storage_usage(const evmc::address& address) const {
+    auto probe = probe_account(address);
+    if (probe.row == accounts().end() || !probe.row->usage.has_value()) return {};
+    return probe.row->usage.value();
+}
+
+void state::store_slot(uint64_t account_id, const evmc::bytes32& location, const evmc::bytes32& value) {
+    auto& db = storage2(account_id);
+    auto probe = probe_slot(account_id, location);
+
+    if (is_zero(value)) {
+        if (probe.row == db.end() || probe.row->is_free()) return;
+
+        auto& delta = usage_deltas[account_id];
+        const uint64_t id = probe.row->id;
+        if (db.find(id + 1) != db.end()) {
+            // keep the row so that slots further down the probe chain stay reachable
+            delta.bytes -= probe.row->value.size();
+            db.modify(probe.row, eosio::same_payer, [&](auto& row){
+                row.value.clear();
+            });
+        } else {
+            // end of the chain, free rows right before it are not needed anymore
+            delta.slots -= 1;
+            delta.bytes -= row_size(*probe.row);
+            db.erase(probe.row);
+            for (uint64_t prev = id - 1;; --prev) {
+                auto itr = db.find(prev);
+                if (itr == db.end() || !itr->is_free()) break;
+                delta.slots -= 1;
+                delta.bytes -= row_size(*itr);
+                db.erase(itr);
+            }
+            forget_slots(account_id, false);
+        }
+        ++stats.storage.remove;
+    } else if (probe.row != db.end()) {
+        auto compact = to_compact_bytes(value);
+        usage_deltas[account_id].bytes += int64_t(compact.size()) - int64_t(probe.row->value.size());
+        db.modify(probe.row, eosio::same_payer, [&](auto& row){
+            row.value = std::move(compact);
+        });
+        ++stats.storage.update;
+    } else {
+        // only writes grow a chain, so bounding them here keeps every read bounded too
+        eosio::check(probe.free - slot_id(location) < max_slot_probe, "storage probe chain too long");
+        auto itr = db.find(probe.free);
+        if (itr != db.end()) {
+            const int64_t before = row_size(*itr);
+            db.modify(itr, eosio::same_payer, [&](auto& row){
+                row.key = to_compact_bytes(location);
+                row.value = to_compact_bytes(value);
+            });
+            usage_deltas[account_id].bytes += row_size(*itr) - before;
+            // the free row may still be cached as the row of the slot that left it
+            forget_slots(account_id, false);
+        } else {
+            itr = db.emplace(_ram_payer, [&](auto& row){
+                row.id = probe.free;
+                row.key = to_compact_bytes(location);
+                row.value = to_compact_bytes(value);
+            });
+            auto& delta = usage_deltas[account_id];
+            ++delta.slots;
+            delta.bytes += row_size(*itr);
+            // misses of the scope may have picked the same free id
+            forget_slots(account_id, true);
+        }
+        slot2probe[{account_id, location}] = {itr, itr->id};
+        ++stats.storage.create;
+    }
+}
+
+bool state::migrate_storage(uint32_t max) {
+    check(!_read_only, "ro state");
+    storage_migration_singleton cursor(_self, _self.value);
+    auto progress = cursor.get_or_default();
+
+    // account ids are never reused, so every scope that may hold legacy rows is below the next id
+    const uint64_t end_id = load_config2().next_account_id;
+    uint64_t id = progress.next_account_id;
+    while( max && id < end_id ) {
+        --max;
+        storage_table legacy(_self, id);
+        auto sitr = legacy.begin();
+        while( max && sitr != legacy.end() ) {
+            store_slot(id, to_bytes32(sitr->key), to_bytes32(sitr->value));
+            sitr = legacy.erase(sitr);
+            --max;
+        }
+        if( sitr != legacy.end() ) break;
+        legacy_storage[id] = false;
+        ++id;
+    }
+
+    progress.next_account_id = id;
+    cursor.set(progress, _self);
+    return id == end_id;
+}
+
+// Storage scopes are keyed by account id and every incarnation gets a new id, so incarnations are
+// not stored. Accounts are read with incarnation 0 and one re-created within the action gets 1.
 uint64_t state::previous_incarnation(const evmc::address& address) const noexcept {
     return 0;
 }
@@ -98,183 +617,331 @@ void state::update_account(const evmc::address& address, std::optional<Account>
     check(!_read_only, "ro state");
     const bool equal{current == initial};
     if(equal) return;
-    
-    account_table accounts(_self, _self.value);
-    auto inx = accounts.get_index<"by.address"_n>();
-    auto itr = inx.find(make_key(address));
-    ++stats.account.read;
 
-    auto emplace = [&](auto& row) {
-        row.id = get_next_account_id();
-        row.eth_address = to_bytes(address);
-        row.nonce = current->nonce;
-        row.balance = to_bytes(current->balance);
-        // Codes are not supposed to changed in this call.
-        row.code_id = std::nullopt;
-        row.flags = 0;
-    };
-
-    auto update = [&](auto& row) {
-        row.nonce = current->nonce;
-        row.balance = to_bytes(current->balance);
-        // Codes are not supposed to changed in this call.
-    };
-
-    auto remove_account = [&](auto& itr) {
-        storage_table db(_self, itr->id);
-        // add to garbage collection table for later removal
-        gc_store_table gc(_self, _self.value);
-        gc.emplace(_ram_payer, [&](auto& row){
-            row.id = gc.available_primary_key();
-            row.storage_id = itr->id;
-        });
-        // Remove code if necessary
-        if (itr->code_id) {
-            account_code_table codes(_self, _self.value);
-            const auto& itrc = codes.get(itr->code_id.value(), "code not found");
-            if(itrc.ref_count-1) {
-                codes.modify(itrc, eosio::same_payer, [&](auto& row){
-                    row.ref_count--;
-                });
-            } else {
-                codes.erase(itrc);
-            }
+    if (changes) {
+        account_change change{.address = to_bytes(address)};
+        if (current) {
+            change.nonce = current->nonce;
+            change.balance = to_compact_bytes(intx::be::store<evmc::bytes32>(current->balance));
+            change.fresh = !initial || initial->incarnation != current->incarnation;
         }
-        accounts.erase(*itr);
-    };
-
+        changes->accounts.push_back(std::move(change));
+    }
+    
+    auto& accounts = this->accounts();
+    auto [itr, key] = load_account(address);
 
     if (current.has_value()) {
-        if (itr == inx.end()) {
-            accounts.emplace(_ram_payer, emplace);
+        if (itr == accounts.end()) {
+            create_account(key, address, current->nonce, current->balance);
             ++stats.account.create;
         } else {
             if( initial && initial->incarnation != current->incarnation ) {
-                remove_account(itr);
-                accounts.emplace(_ram_payer, emplace);
+                // the address keeps its row, a new id gives it a fresh storage scope while the
+                // old one is left to gc. Flags belong to the address, not to its storage, so a
+                // frozen address stays frozen.
+                // Storage is written before accounts, so the writes buffered for the address are
+                // the ones of the new incarnation and go along to its scope
+                const uint64_t old_id = itr->id;
+                std::vector<std::pair<slot_write, evmc::bytes32>> writes(
+                    pending_slots.lower_bound(slot_write{old_id, 0, evmc::bytes32{}}),
+                    pending_slots.lower_bound(slot_write{old_id + 1, 0, evmc::bytes32{}}));
+                retire_account(itr);
+                const uint64_t id = get_next_account_id();
+                accounts.modify(itr, eosio::same_payer, [&](auto& row){
+                    row.id = id;
+                    row.nonce = current->nonce;
+                    row.set_balance(current->balance);
+                    row.code_id.reset();
+                    row.usage.emplace();
+                });
+                addr2id[address] = id;
+                for (auto& [write, value] : writes) {
+                    std::get<0>(write) = id;
+                    pending_slots.emplace(write, value);
+                }
+                ++stats.account.create;
             } else {
-                accounts.modify(*itr, eosio::same_payer, update);
+                accounts.modify(itr, eosio::same_payer, [&](auto& row){
+                    row.nonce = current->nonce;
+                    row.set_balance(current->balance);
+                    // Codes are not supposed to changed in this call.
+                });
                 ++stats.account.update;
             }
         }
     } else {
-        if(itr != inx.end()) {
+        if(itr != accounts.end()) {
             remove_account(itr);
             ++stats.account.remove;
         }
     }
 }
 
-bool state::gc(uint32_t max) {
+gc_progress state::load_gc_progress() const {
+    gc_progress_singleton singleton(_self, _self.value);
+    if (singleton.exists()) return singleton.get();
+
+    // A backlog queued by an older contract is left to `countgc`, transactions never walk it
+    gc_progress progress;
     gc_store_table gc(_self, _self.value);
-    auto i = gc.begin();
-    while( max && i != gc.end() ) {
+    if (auto first = gc.begin(); first != gc.end()) {
+        progress.uncounted_from = first->id;
+    }
+    return progress;
+}
+
+bool state::count_gc(uint32_t max) {
+    check(!_read_only, "ro state");
+    auto progress = load_gc_progress();
+    if (!progress.uncounted_from.has_value()) return true;
+
+    gc_store_table gc(_self, _self.value);
+    auto i = gc.lower_bound(*progress.uncounted_from);
+    if (!max && i != gc.end()) return false;
+    for (; max && i != gc.end(); ++i, --max) {
+        ++progress.entries;
+    }
+    if (i == gc.end()) {
+        progress.uncounted_from.reset();
+    } else {
+        progress.uncounted_from = i->id;
+    }
+    gc_progress_singleton(_self, _self.value).set(progress, _self);
+    return !progress.uncounted_from.has_value();
+}
+
+gc_result state::gc(uint32_t max) {
+    gc_result res;
+    auto progress = load_gc_progress();
+    if (!progress.entries && !progress.uncounted_from.has_value()) return res;
+
+    const auto next_id = progress.next_id;
+    const auto entries = progress.entries;
+    gc_store_table gc(_self, _self.value);
+    auto i = gc.lower_bound(progress.next_id);
+    while( max && gc.begin() != gc.end() ) {
+        if( i == gc.end() ) i = gc.begin();
+
         storage_table db(_self, i->storage_id);
         auto sitr = db.begin();
         while( max && sitr != db.end() ) {
             sitr = db.erase(sitr);
             --max;
+            ++res.rows_deleted;
+        }
+        auto& db2 = storage2(i->storage_id);
+        auto sitr2 = db2.begin();
+        while( max && sitr2 != db2.end() ) {
+            sitr2 = db2.erase(sitr2);
+            --max;
+            ++res.rows_deleted;
+        }
+        forget_slots(i->storage_id, false);
+        if( !max ) {
+            // a large scope must not hold back the entries queued after it
+            ++i;
+            break;
+        }
+        if (progress.is_counted(i->id)) {
+            --progress.entries;
         }
-        if( !max ) break;
         i = gc.erase(i);
         --max;
+        ++res.entries_completed;
     }
 
-    return gc.begin() == gc.end();
+    progress.next_id = i != gc.end() ? i->id : 0;
+    if (progress.next_id != next_id || progress.entries != entries) {
+        gc_progress_singleton(_self, _self.value).set(progress, _self);
+    }
+    res.backlog = progress.entries;
+    return res;
 }
 
-void state::update_account_code(const evmc::address& address, uint64_t, const evmc::bytes32& code_hash, ByteView code) {
+gc_backlog state::inspect_gc(uint32_t max_entries, uint32_t max_rows) const {
+    gc_backlog res;
+    res.entries = load_gc_progress().entries;
+
+    gc_store_table gc(_self, _self.value);
+    gc_progress_singleton singleton(_self, _self.value);
+    const auto start = gc.lower_bound(singleton.get_or_default().next_id);
+    auto i = start;
+    while( res.next.size() < max_entries && gc.begin() != gc.end() ) {
+        if( i == gc.end() ) i = gc.begin();
+
+        gc_backlog_entry entry{i->id, i->storage_id, 0};
+        storage_table db(_self, i->storage_id);
+        for( auto sitr = db.begin(); entry.rows < max_rows && sitr != db.end(); ++sitr ) {
+            ++entry.rows;
+        }
+        storage2_table db2(_self, i->storage_id);
+        for( auto sitr2 = db2.begin(); entry.rows < max_rows && sitr2 != db2.end(); ++sitr2 ) {
+            ++entry.rows;
+        }
+        res.next.push_back(entry);
+
+        if( ++i == start || (i == gc.end() && start == gc.begin()) ) break;
+    }
+    return res;
+}
+
+void state::remove_gc_entry(uint64_t id) {
+    check(!_read_only, "ro state");
+    auto progress = load_gc_progress();
+    gc_store_table gc(_self, _self.value);
+    auto itr = gc.find(id);
+    check(itr != gc.end(), "gc row not found");
+    gc.erase(itr);
+
+    if (progress.is_counted(id)) {
+        --progress.entries;
+        gc_progress_singleton(_self, _self.value).set(progress, _self);
+    }
+}
+
+bool state::migrate_code(uint32_t max) {
     check(!_read_only, "ro state");
     account_code_table codes(_self, _self.value);
-    auto inxc = codes.get_index<"by.codehash"_n>();
-    auto itrc = inxc.find(make_key(code_hash));
-    uint64_t code_id;
-    if(itrc == inxc.end()) {
-        code_id = codes.available_primary_key();
-        codes.emplace(_ram_payer, [&](auto& row){
-            row.id = code_id;
-            row.code_hash = to_bytes(code_hash);
-            row.code = bytes{code.begin(), code.end()};
-            row.ref_count = 1;
+    auto itr = codes.begin();
+    while( max && itr != codes.end() ) {
+        itr = migrate_code_row(codes, itr, 0);
+        --max;
+    }
+    return codes.begin() == codes.end();
+}
+
+void state::release_code(uint64_t code_id) {
+    check(!_read_only, "ro state");
+    code_meta_table metas(_self, _self.value);
+    auto mitr = metas.find(code_id);
+    if(mitr == metas.end()) {
+        account_code_table codes(_self, _self.value);
+        auto itrc = codes.find(code_id);
+        check(itrc != codes.end(), "code not found");
+        if(itrc->ref_count-1) {
+            migrate_code_row(codes, itrc, -1);
+        } else {
+            codes.erase(itrc);
+        }
+        return;
+    }
+
+    if(mitr->ref_count-1) {
+        // only the metadata row is re-serialized, the code blob is untouched
+        metas.modify(mitr, eosio::same_payer, [&](auto& row){
+            row.ref_count--;
         });
     } else {
+        code_blob_table blobs(_self, _self.value);
+        blobs.erase(blobs.get(code_id, "code not found"));
+        metas.erase(mitr);
+    }
+}
+
+uint64_t state::next_code_id() const {
+    // ids of migrated rows are preserved, so new ids must not collide with legacy ones
+    account_code_table codes(_self, _self.value);
+    code_meta_table metas(_self, _self.value);
+    return std::max(codes.available_primary_key(), metas.available_primary_key());
+}
+
+account_code_table::const_iterator state::migrate_code_row(account_code_table& codes, account_code_table::const_iterator itr, int32_t ref_delta) {
+    code_meta_table metas(_self, _self.value);
+    metas.emplace(_ram_payer, [&](auto& row){
+        row.id = itr->id;
+        row.ref_count = itr->ref_count + ref_delta;
+        row.code_hash = itr->code_hash;
+    });
+    code_blob_table blobs(_self, _self.value);
+    blobs.emplace(_ram_payer, [&](auto& row){
+        row.id = itr->id;
+        row.code = itr->code;
+        row.analysis = analyze_code(ByteView{(const uint8_t*)itr->code.data(), itr->code.size()});
+    });
+    return codes.erase(itr);
+}
+
+void state::update_account_code(const evmc::address& address, uint64_t, const evmc::bytes32& code_hash, ByteView code) {
+    check(!_read_only, "ro state");
+    code_meta_table metas(_self, _self.value);
+    auto inxm = metas.get_index<"by.codehash"_n>();
+    auto itrm = inxm.find(make_key(code_hash));
+    uint64_t code_id;
+    if(itrm != inxm.end()) {
         // code should be immutable
-        codes.modify(*itrc, eosio::same_payer, [&](auto& row){
+        metas.modify(*itrm, eosio::same_payer, [&](auto& row){
             row.ref_count++;
         });
-        code_id = itrc->id;
+        code_id = itrm->id;
+    } else {
+        account_code_table codes(_self, _self.value);
+        auto inxc = codes.get_index<"by.codehash"_n>();
+        auto itrc = inxc.find(make_key(code_hash));
+        if(itrc != inxc.end()) {
+            code_id = itrc->id;
+            migrate_code_row(codes, codes.iterator_to(*itrc), 1);
+        } else {
+            code_id = next_code_id();
+            metas.emplace(_ram_payer, [&](auto& row){
+                row.id = code_id;
+                row.code_hash = to_bytes(code_hash);
+                row.ref_count = 1;
+            });
+            code_blob_table blobs(_self, _self.value);
+            blobs.emplace(_ram_payer, [&](auto& row){
+                row.id = code_id;
+                row.code = bytes{code.begin(), code.end()};
+                row.analysis = analyze_code(code);
+            });
+        }
     }
     
-    account_table accounts(_self, _self.value);
-    auto inx = accounts.get_index<"by.address"_n>();
-    auto itr = inx.find(make_key(address));
-    ++stats.account.read;
-    if( itr != inx.end() ) {
-        accounts.modify(*itr, eosio::same_payer, [&](auto& row){
-            row.code_id = code_id;
-        });
-        ++stats.account.update;
-    } else {
-        accounts.emplace(_ram_payer, [&](auto& row){
-            row.id = get_next_account_id();;
-            row.eth_address = to_bytes(address);
-            row.nonce = 0;
-            row.code_id = code_id;
-        });
+    auto& accounts = this->accounts();
+    auto [itr, key] = load_account(address);
+    if( itr == accounts.end() ) {
+        itr = create_account(key, address);
+        addr2id[address] = itr->id;
         ++stats.account.create;
     }
+    accounts.modify(itr, eosio::same_payer, [&](auto& row){
+        row.code_id = code_id;
+    });
+    ++stats.account.update;
+
+    if (changes) {
+        changes->codes.push_back(code_change{to_bytes(address), code_id, to_bytes(code_hash)});
+    }
 }
 
 void state::update_storage(const evmc::address& address, uint64_t incarnation, const evmc::bytes32& location,
                                    const evmc::bytes32& initial, const evmc::bytes32& current) {
     
     check(!_read_only, "ro state");
-    account_table accounts(_self, _self.value);
-    auto inx = accounts.get_index<"by.address"_n>();
-    auto itr = inx.find(make_key(address));
-    ++stats.account.read;
 
-    if (is_zero(current)) {
-        if(itr == inx.end()) return;
-        storage_table db(_self, itr->id);
-        auto inx2 = db.get_index<"by.key"_n>();
-        auto itr2 = inx2.find(make_key(location));
-        ++stats.storage.read;
-        if(itr2 == inx2.end()) return;
-        db.erase(*itr2);
-        ++stats.storage.remove;
-    } else {
-        uint64_t table_id;
-        if(itr == inx.end()){
-            accounts.emplace(_ram_payer, [&](auto& row){
-                table_id = get_next_account_id();
-                row.id = table_id;
-                row.eth_address = to_bytes(address);
-                row.nonce = 0;
-                row.code_id = std::nullopt;
-            });
-            ++stats.account.read;
+    auto cached = addr2id.find(address);
+    if (cached == addr2id.end()) {
+        auto probe = probe_account(address);
+        if (probe.row != accounts().end()) {
+            cached = addr2id.emplace(address, probe.row->id).first;
+        } else if (auto legacy = find_legacy_account(address)) {
+            cached = addr2id.emplace(address, legacy->id).first;
+        } else if (is_zero(current)) {
+            return;
         } else {
-            table_id = itr->id;
+            cached = addr2id.emplace(address, create_account(probe.key, address)->id).first;
+            ++stats.account.create;
         }
+    }
 
-        storage_table db(_self, table_id);
-        auto inx2 = db.get_index<"by.key"_n>();
-        auto itr2 = inx2.find(make_key(location));
-        ++stats.storage.read;
-        if(itr2 == inx2.end()) {
-            db.emplace(_ram_payer, [&](auto& row){
-                row.id = db.available_primary_key();
-                row.key = to_bytes(location);
-                row.value = to_bytes(current);
-            });
-            ++stats.storage.create;
-        } else {
-            db.modify(*itr2, eosio::same_payer, [&](auto& row){
-                row.value = to_bytes(current);
-            });
-            ++stats.storage.update;
-        }
+    // Only writes that change the slot are reported, after the ones dropped above
+    if (changes && initial != current) {
+        changes->storage.push_back(storage_change{to_bytes(address), to_compact_bytes(location), to_compact_bytes(current)});
+    }
+
+    const slot_write write{cached->second, slot_id(location), location};
+    if (!pending_slots.insert_or_assign(write, current).second) {
+        ++stats.coalesced;
     }
 }
 
@@ -331,7 +998,7 @@ evmc::bytes32 state::state_root_hash() const {
     return {};
 }
 
-uint64_t state::get_next_account_id() {
+config2& state::load_config2() {
     if(!_config2) {
         eosio::singleton<"config2"_n, config2> cfg2{_self, _self.value};
         if(cfg2.exists()) {
@@ -341,12 +1008,20 @@ uint64_t state::get_next_account_id() {
             _config2 = config2{accounts.available_primary_key()};
         }
     }
-    auto id = _config2->next_account_id;
-    _config2->next_account_id++;
-    return id;
+    return *_config2;
+}
+
+uint64_t state::get_next_account_id() {
+    return load_config2().next_account_id++;
 }
 
 state::~state() {
+    if(!_read_only) flush();
+
+    for(const auto& [code_hash, code] : addr2code) {
+        unregister_code_analysis(ByteView{(const uint8_t*)code.data(), code.size()});
+    }
+
     if(!_config2.has_value()) return;
     eosio::singleton<"config2"_n, config2> cfg2{_self, _self.value};
     cfg2.set(_config2.value(), _self);
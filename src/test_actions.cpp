@@ -6,6 +6,7 @@
 #include <evm_runtime/test/config.hpp>
 #include <evm_runtime/runtime_config.hpp>
 #include <evm_runtime/transaction.hpp>
+
 namespace evm_runtime {
 using namespace silkworm;
 
@@ -32,7 +33,9 @@ using namespace silkworm;
             .enforce_chain_id = false,
             .allow_non_self_miner = true
         };
-        execute_tx(rc, eosio::name{}, block, transaction{std::move(tx)}, ep);
+        tx_accumulator acc;
+        execute_tx(rc, eosio::name{}, block, transaction{std::move(tx)}, ep, acc);
+        settle_txs(eosio::name{}, acc);
     }
     engine.finalize(ep.state(), ep.evm().block());
     ep.state().write_to_db(ep.evm().block().header.number);
@@ -43,21 +46,21 @@ using namespace silkworm;
 
     eosio::require_auth(get_self());
 
-    account_table accounts(_self, _self.value);
-    auto inx = accounts.get_index<"by.address"_n>();
-    auto itr = inx.find(make_key(to_address(addy)));
-    if(itr == inx.end()) {
+    evm_runtime::state state{_self, _self, true};
+    const auto address = to_address(addy);
+    if(!state.read_account(address)) {
         eosio::print("no data for: ");
         eosio::printhex(addy.data(), addy.size());
         eosio::print("\n");
         return;
     }
+    const uint64_t account_id = state.addr2id[address];
 
     eosio::print("storage: ");
     eosio::printhex(addy.data(), addy.size());
 
     uint64_t cnt=0;
-    storage_table db(_self, itr->id);
+    storage_table db(_self, account_id);
     auto sitr = db.begin();
     while(sitr != db.end()) {
         eosio::print("\n");
@@ -68,6 +71,17 @@ using namespace silkworm;
         ++sitr;
         ++cnt;
     }
+    storage2_table db2(_self, account_id);
+    for(auto sitr2 = db2.begin(); sitr2 != db2.end(); ++sitr2) {
+        const auto key = from_compact_bytes(sitr2->key);
+        const auto value = from_compact_bytes(sitr2->value);
+        eosio::print("\n");
+        eosio::printhex(key.bytes, sizeof(key.bytes));
+        eosio::print(":");
+        eosio::printhex(value.bytes, sizeof(value.bytes));
+        eosio::print("\n");
+        ++cnt;
+    }
 
     eosio::print(" = ", cnt, "\n");
 }
@@ -85,21 +99,40 @@ using namespace silkworm;
         eosio::print("\n");
     };
 
-    account_table accounts(_self, _self.value);
-    auto itr = accounts.begin();
-    eosio::print("DUMPALL start\n");
-    while( itr != accounts.end() ) {
+    auto print_store2 = [](auto sitr) {
+        const auto key = from_compact_bytes(sitr->key);
+        const auto value = from_compact_bytes(sitr->value);
+        eosio::print("    ");
+        eosio::printhex(key.bytes, sizeof(key.bytes));
+        eosio::print(":");
+        eosio::printhex(value.bytes, sizeof(value.bytes));
+        eosio::print("\n");
+    };
+
+    auto dump_account = [&](uint64_t id, const evmc::address& address) {
         eosio::print("  account:");
-        eosio::printhex(itr->eth_address.data(), itr->eth_address.size());
+        eosio::printhex(address.bytes, sizeof(address.bytes));
         eosio::print("\n");
-        storage_table db(_self, itr->id);
+        storage_table db(_self, id);
         auto sitr = db.begin();
         while( sitr != db.end() ) {
             print_store( sitr );
             sitr++;
         }
-        
-        itr++;
+        storage2_table db2(_self, id);
+        for( auto sitr2 = db2.begin(); sitr2 != db2.end(); ++sitr2 ) {
+            print_store2( sitr2 );
+        }
+    };
+
+    eosio::print("DUMPALL start\n");
+    account_table accounts(_self, _self.value);
+    for( auto itr = accounts.begin(); itr != accounts.end(); ++itr ) {
+        dump_account(itr->id, to_address(itr->eth_address));
+    }
+    account2_table accounts2(_self, _self.value);
+    for( auto itr = accounts2.begin(); itr != accounts2.end(); ++itr ) {
+        dump_account(itr->id, itr->get_address());
     }
     eosio::print("  gc:");
     gc_store_table gc(_self, _self.value);
@@ -114,6 +147,10 @@ using namespace silkworm;
             print_store( sitr );
             ++sitr;
         }
+        storage2_table db2(_self, i->storage_id);
+        for( auto sitr2 = db2.begin(); sitr2 != db2.end(); ++sitr2 ) {
+            print_store2( sitr2 );
+        }
 
         ++i;
     }
@@ -126,14 +163,11 @@ using namespace silkworm;
 
     eosio::require_auth(get_self());
 
-    account_table accounts(_self, _self.value);
-    auto itr = accounts.begin();
-    eosio::print("CLEAR start\n");
-    while( itr != accounts.end() ) {
+    auto clear_account = [&](uint64_t id, const evmc::address& address) {
         eosio::print("  account:");
-        eosio::printhex(itr->eth_address.data(), itr->eth_address.size());
+        eosio::printhex(address.bytes, sizeof(address.bytes));
         eosio::print("\n");
-        storage_table db(_self, itr->id);
+        storage_table db(_self, id);
         auto sitr = db.begin();
         while( sitr != db.end() ) {
             eosio::print("    ");
@@ -144,20 +178,54 @@ using namespace silkworm;
             sitr = db.erase(sitr);
         }
 
+        storage2_table db2(_self, id);
+        auto sitr2 = db2.begin();
+        while( sitr2 != db2.end() ) {
+            sitr2 = db2.erase(sitr2);
+        }
+
         auto db_size = std::distance(db.cbegin(), db.cend());
         eosio::print("db size:", uint64_t(db_size), "\n");
+    };
+
+    eosio::print("CLEAR start\n");
+    account_table accounts(_self, _self.value);
+    auto itr = accounts.begin();
+    while( itr != accounts.end() ) {
+        clear_account(itr->id, to_address(itr->eth_address));
         itr = accounts.erase(itr);
     }
 
+    account2_table accounts2(_self, _self.value);
+    auto itr2 = accounts2.begin();
+    while( itr2 != accounts2.end() ) {
+        clear_account(itr2->id, itr2->get_address());
+        itr2 = accounts2.erase(itr2);
+    }
+
     account_code_table codes(_self, _self.value);
     auto itrc = codes.begin();
     while(itrc != codes.end()) {
         itrc = codes.erase(itrc);
     }
 
+    code_meta_table metas(_self, _self.value);
+    auto itrm = metas.begin();
+    while(itrm != metas.end()) {
+        itrm = metas.erase(itrm);
+    }
+
+    code_blob_table blobs(_self, _self.value);
+    auto itrb = blobs.begin();
+    while(itrb != blobs.end()) {
+        itrb = blobs.erase(itrb);
+    }
+
+    storage_migration_singleton(_self, _self.value).remove();
+
     gc(std::numeric_limits<uint32_t>::max());
 
-    auto account_size = std::distance(accounts.cbegin(), accounts.cend());
+    auto account_size = std::distance(accounts.cbegin(), accounts.cend()) + std::distance(accounts2.cbegin(), accounts2.cend());
     eosio::print("accounts size:", uint64_t(account_size), "\n");
 
     eosio::print("CLEAR end\n");
@@ -219,23 +287,36 @@ using namespace silkworm;
 
     eosio::require_auth(get_self());
 
-    account_table accounts(_self, _self.value);
-    auto inx = accounts.get_index<"by.address"_n>();
-    auto itr = inx.find(make_key(addy));
-
-    if(itr == inx.end()) {
-        accounts.emplace(get_self(), [&](auto& row){
-            row.id = accounts.available_primary_key();;
-            row.code_id = std::nullopt;
-            row.eth_address = addy;
-            row.balance = bal;
-        });
+    evm_runtime::state state{_self, _self};
+    const auto address = to_address(addy);
+    const auto initial = state.read_account(address);
+
+    auto current = initial.value_or(Account{});
+    current.balance = to_uint256(bal);
+    state.update_account(address, initial, current);
+}
+
+#ifdef WITH_K1_RECOVER
+[[eosio::action]] void evm_contract::testrecover(const bytes& rlptx, const bytes& sender) {
+    eosio::require_auth(get_self());
+
+    Transaction tx;
+    ByteView bv{(const uint8_t*)rlptx.data(), rlptx.size()};
+    eosio::check(rlp::decode(bv, tx) && bv.empty(), "unable to decode transaction");
+
+    // Both recovery backends must agree, including on failure.
+    auto from_k1 = transaction::recover_sender_k1(tx);
+    tx.from.reset();
+    tx.recover_sender();
+    eosio::check(from_k1 == tx.from, "recovered senders differ");
+
+    if(sender.empty()) {
+        eosio::check(!tx.from.has_value(), "unexpected sender");
     } else {
-        accounts.modify(*itr, eosio::same_payer, [&](auto& row){
-            row.balance = bal;
-        });
+        eosio::check(tx.from.has_value() && *tx.from == to_address(sender), "unexpected sender");
     }
 }
+#endif
 
 [[eosio::action]] void evm_contract::testbaldust(const name test) {
     if(test == "basic"_n) {
@@ -378,4 +459,69 @@ using namespace silkworm;
     }
 }
 
-}
\ No newline at end of file
+[[eosio::action]] db_stats evm_contract::teststate(const bytes& addy, const std::vector<bytes>& locations, const bytes& value, bool warm) {
+    assert_unfrozen();
+
+    eosio::require_auth(get_self());
+
+    // Same calls the execution makes for a transaction that loads and then stores each slot,
+    // after validation has already looked at the account and the slots once
+    evm_runtime::state state{get_self(), get_self()};
+    const auto address = to_address(addy);
+    if (warm) {
+        AccessListEntry entry{address};
+        for (const auto& location : locations) {
+            entry.storage_keys.push_back(to_bytes32(location));
+        }
+        state.warm_up({entry});
+    }
+    const auto initial = state.read_account(address);
+    state.read_account(address);
+
+    for (const auto& location : locations) {
+        state.read_storage(address, 0, to_bytes32(location));
+    }
+    for (const auto& location : locations) {
+        const auto loc = to_bytes32(location);
+        const auto prev = state.read_storage(address, 0, loc);
+        state.update_storage(address, 0, loc, prev, to_bytes32(value));
+    }
+
+    if (initial) {
+        auto current = *initial;
+        ++current.nonce;
+        state.update_account(address, initial, current);
+    }
+    state.flush();
+    return state.stats;
+}
+
+[[eosio::action]] void evm_contract::testmixedtx(eosio::name miner, std::vector<bytes> rlptxs) {
+    eosio::require_auth(get_self());
+
+    // The first transaction comes from the action data, the others as if the contract built them
+    std::vector<transaction> txs;
+    txs.reserve(rlptxs.size());
+    for (auto& rlptx : rlptxs) {
+        if (txs.empty()) {
+            txs.emplace_back(std::move(rlptx));
+        } else {
+            txs.emplace_back(silkworm::Transaction{transaction(std::move(rlptx)).get_tx()});
+        }
+    }
+    process_txs(runtime_config{}, miner, txs, {});
+}
+
+[[eosio::action]] void evm_contract::testrlpmove(const bytes& rlptx) {
+    eosio::require_auth(get_self());
+
+    // The buffer handed to a transaction must be the one decoded from and released to the event
+    bytes owned{rlptx};
+    const char* buffer = owned.data();
+    transaction txn(std::move(owned));
+    txn.get_tx();
+    eosio::check(txn.get_rlptx().data() == buffer, "rlp copied when decoding");
+    auto released = txn.release_rlptx();
+    eosio::check(released.data() == buffer, "rlp copied when released");
+}
+}
@@ -1,5 +1,6 @@
 #include <eosio/eosio.hpp>
 #include <eosio/fixed_bytes.hpp>
+#include <algorithm>
 #include <evm_runtime/types.hpp>
 
 namespace evm_runtime {
@@ -53,6 +54,18 @@ evmc::bytes32 to_bytes32(const bytes& data) {
     return res;
 }
 
+bytes to_compact_bytes(const evmc::bytes32& val) {
+    auto first = std::find_if(std::begin(val.bytes), std::end(val.bytes), [](uint8_t b){ return b != 0; });
+    return bytes{first, std::end(val.bytes)};
+}
+
+evmc::bytes32 from_compact_bytes(const bytes& data) {
+    evmc::bytes32 res;
+    eosio::check(data.size() <= 32, "wrong length");
+    memcpy(res.bytes + 32 - data.size(), data.data(), data.size());
+    return res;
+}
+
 uint256 to_uint256(const bytes& value) {
     uint8_t tmp[32]{0};
     eosio::check(value.size() <= 32, "wrong length");
@@ -0,0 +1,171 @@
+#include <evm_runtime/vault_wrapper.hpp>
+
+namespace evm_runtime {
+
+vault_wrapper::vault_wrapper(eosio::name self, eosio::name first_receiver) :
+    _self(self), _first_receiver(first_receiver), _vaults(self, self.value) {}
+
+vault_wrapper::~vault_wrapper() {
+    flush();
+}
+
+vault_wrapper::pending_change& vault_wrapper::pending(const vault& row) {
+    return _pending.try_emplace(row.owner, pending_change{&row, row.balance, row.next_nonce}).first->second;
+}
+
+balance_with_dust& vault_wrapper::pending_balance(const vault& row) {
+    return pending(row).balance;
+}
+
+void vault_wrapper::take_pending(vault& row) {
+    auto itr = _pending.find(row.owner);
+    if (itr == _pending.end()) return;
+    row.balance = itr->second.balance;
+    row.next_nonce = itr->second.next_nonce;
+    _pending.erase(itr);
+}
+
+void vault_wrapper::add(const vault& row, const intx::uint256& amount) {
+    pending_balance(row) += amount;
+}
+
+void vault_wrapper::add(const vault& row, const eosio::asset& quantity) {
+    pending_balance(row).balance += quantity;
+}
+
+void vault_wrapper::subtract(const vault& row, const intx::uint256& amount) {
+    pending_balance(row) -= amount;
+}
+
+void vault_wrapper::flush() {
+    auto pending = std::move(_pending);
+    _pending.clear();
+    for (const auto& [owner, change] : pending) {
+        if (change.balance == change.row->balance && change.next_nonce == change.row->next_nonce) continue;
+        _vaults.modify(*change.row, eosio::same_payer, [&](vault& v) {
+            v.balance = change.balance;
+            v.next_nonce = change.next_nonce;
+        });
+    }
+}
+
+bool vault_wrapper::has_legacy_rows() {
+    if (!_has_legacy_rows) {
+        balances legacy_balances(_self, _self.value);
+        nextnonces legacy_nonces(_self, _self.value);
+        _has_legacy_rows = legacy_balances.begin() != legacy_balances.end() ||
+                           legacy_nonces.begin() != legacy_nonces.end();
+    }
+    return *_has_legacy_rows;
+}
+
+vaults::const_iterator vault_wrapper::migrate_owner(eosio::name owner) {
+    balances legacy_balances(_self, _self.value);
+    nextnonces legacy_nonces(_self, _self.value);
+    auto bitr = legacy_balances.find(owner.value);
+    auto nitr = legacy_nonces.find(owner.value);
+    if (bitr == legacy_balances.end() && nitr == legacy_nonces.end()) return _vaults.end();
+
+    // Legacy rows were paid by their owner, who keeps paying for the merged row when it authorized
+    // the action. RAM can't be billed to it otherwise, or in a notification, so the contract takes
+    // on the row then: one `vaults` row per legacy owner merged that way, at most.
+    const bool owner_pays = _first_receiver == _self && eosio::has_auth(owner);
+    auto itr = _vaults.emplace(owner_pays ? owner : _self, [&](vault& row) {
+        row.owner = owner;
+        row.open = bitr != legacy_balances.end();
+        if (row.open) row.balance = bitr->balance;
+        if (nitr != legacy_nonces.end()) row.next_nonce = nitr->next_nonce;
+    });
+    if (bitr != legacy_balances.end()) legacy_balances.erase(bitr);
+    if (nitr != legacy_nonces.end()) legacy_nonces.erase(nitr);
+    return itr;
+}
+
+vaults::const_iterator vault_wrapper::load(eosio::name owner) {
+    auto itr = _vaults.find(owner.value);
+    if (itr == _vaults.end() && has_legacy_rows()) {
+        itr = migrate_owner(owner);
+    }
+    return itr;
+}
+
+const vault* vault_wrapper::find(eosio::name owner) {
+    auto itr = load(owner);
+    if (itr == _vaults.end() || !itr->open) return nullptr;
+    return &*itr;
+}
+
+const vault& vault_wrapper::get(eosio::name owner, const char* error) {
+    auto row = find(owner);
+    eosio::check(row != nullptr, error);
+    return *row;
+}
+
+void vault_wrapper::open(eosio::name owner, const eosio::symbol& token_symbol) {
+    auto itr = load(owner);
+    if (itr == _vaults.end()) {
+        _vaults.emplace(owner, [&](vault& row) {
+            row.owner = owner;
+            row.balance.balance = eosio::asset(0, token_symbol);
+        });
+    } else if (!itr->open) {
+        _vaults.modify(itr, eosio::same_payer, [&](vault& row) {
+            row.open = true;
+            row.balance = balance_with_dust{eosio::asset(0, token_symbol), 0};
+        });
+    }
+}
+
+void vault_wrapper::close(eosio::name owner) {
+    flush();
+    const vault& row = get(owner, "account is not open");
+    eosio::check(row.balance.is_zero(), "cannot close because balance is not zero");
+
+    //if the account has performed an EOS->EVM transfer the nonce needs to be maintained in case the account is re-opened in the future
+    if (row.next_nonce == 0) {
+        _vaults.erase(row);
+    } else {
+        _vaults.modify(row, eosio::same_payer, [](vault& r) {
+            r.open = false;
+        });
+    }
+}
+
+uint64_t vault_wrapper::get_next_nonce(eosio::name owner) {
+    if (auto pitr = _pending.find(owner); pitr != _pending.end()) return pitr->second.next_nonce;
+    auto itr = _vaults.find(owner.value);
+    if (itr != _vaults.end()) return itr->next_nonce;
+    if (has_legacy_rows()) {
+        // read only, anyone can assert a nonce
+        nextnonces legacy_nonces(_self, _self.value);
+        auto nitr = legacy_nonces.find(owner.value);
+        if (nitr != legacy_nonces.end()) return nitr->next_nonce;
+    }
+    return 0;
+}
+
+uint64_t vault_wrapper::get_and_increment_nonce(eosio::name owner) {
+    // written by flush together with the balance the call is paid from
+    return pending(get(owner, "caller account has not been opened")).next_nonce++;
+}
+
+bool vault_wrapper::migrate(uint32_t max) {
+    balances legacy_balances(_self, _self.value);
+    nextnonces legacy_nonces(_self, _self.value);
+    for (; max; --max) {
+        // owners closed with a used nonce only have a `nextnonces` row
+        auto bitr = legacy_balances.begin();
+        if (bitr != legacy_balances.end()) {
+            migrate_owner(bitr->owner);
+            continue;
+        }
+        auto nitr = legacy_nonces.begin();
+        if (nitr == legacy_nonces.end()) break;
+        migrate_owner(nitr->owner);
+    }
+    _has_legacy_rows = legacy_balances.begin() != legacy_balances.end() ||
+                       legacy_nonces.begin() != legacy_nonces.end();
+    return !*_has_legacy_rows;
+}
+
+} //namespace evm_runtime
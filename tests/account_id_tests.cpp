@@ -10,19 +10,12 @@ struct account_id_tester : basic_evm_tester {
    }
 
    std::optional<uint64_t> get_max_account_id() {
-      const auto& db = control->db();
-      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>( boost::make_tuple( evm_account_name, evm_account_name, "account"_n ) );
-      if ( !t_id ) return {};
-
-      const auto& idx = db.get_index<chain::key_value_index, chain::by_scope_primary>();
-      if( idx.begin() == idx.end() ) return {};
-      
-      decltype(t_id->id) next_tid(t_id->id._id + 1);
-      auto itr = idx.lower_bound(boost::make_tuple(next_tid));
-      if(itr == idx.end() || itr->t_id == next_tid) --itr;
-
-      if(itr->t_id._id != t_id->id._id) return {};
-      return itr->primary_key;
+      std::optional<uint64_t> max_id;
+      scan_accounts([&](account_object&& account) -> bool {
+         max_id = std::max(max_id.value_or(0), account.id);
+         return false;
+      });
+      return max_id;
    }
 
    std::string int_str32(uint32_t x) {
@@ -0,0 +1,280 @@
+#include "basic_evm_tester.hpp"
+#include <silkworm/core/types/account.hpp>
+#include <ethash/keccak.hpp>
+
+using namespace evm_test;
+
+struct account_table_tester : basic_evm_tester {
+   evm_eoa evm1;
+
+   account_table_tester() {
+      create_accounts({"alice"_n});
+      transfer_token(faucet_account_name, "alice"_n, make_asset(10000'0000));
+      init();
+   }
+
+   transaction_trace_ptr transfer(evm_eoa& from, const evmc::address& to, const intx::uint256& value) {
+      auto txn = generate_tx(to, value);
+      from.sign(txn);
+      return pushtx(txn);
+   }
+
+   std::map<uint64_t, account2_table_row> account2_rows() const {
+      std::map<uint64_t, account2_table_row> res;
+      scan_table<account2_table_row>("account2"_n, evm_account_name, [&](account2_table_row&& row) {
+         res[row.key] = row;
+         return false;
+      });
+      return res;
+   }
+
+   bool migrated(const evmc::address& address) const {
+      auto rows = account2_rows();
+      auto itr = rows.find(account_key(address));
+      return itr != rows.end() && std::memcmp(itr->second.eth_address.data(), address.bytes, sizeof(address.bytes)) == 0;
+   }
+
+   transaction_trace_ptr updateaccnt(const evmc::address& address, const silkworm::Account& initial, const silkworm::Account& current) {
+      return push_action(evm_account_name, "updateaccnt"_n, evm_account_name,
+         mvo()("address", to_bytes(address))
+              ("initial", to_bytes(initial.encode_for_storage()))
+              ("current", to_bytes(current.encode_for_storage())));
+   }
+
+   const chain::key_value_object* find_account2_row(uint64_t key) const {
+      const auto& db = control->db();
+      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+         boost::make_tuple(evm_account_name, evm_account_name, "account2"_n));
+      BOOST_REQUIRE(t_id);
+      return db.find<chain::key_value_object, chain::by_scope_primary>(boost::make_tuple(t_id->id, key));
+   }
+
+   // Puts a copy of the row at `from` under `key` with the given id, as a collision would
+   void plant_account2_row(uint64_t from, uint64_t key, uint64_t id) {
+      auto& db = const_cast<chainbase::database&>(control->db());
+      const auto* src = find_account2_row(from);
+      BOOST_REQUIRE(src);
+      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+         boost::make_tuple(evm_account_name, evm_account_name, "account2"_n));
+      db.create<chain::key_value_object>([&](auto& kv) {
+         kv.t_id = t_id->id;
+         kv.primary_key = key;
+         kv.payer = src->payer;
+         kv.value.assign(src->value.data(), src->value.size());
+         std::memcpy(kv.value.data(), &key, sizeof(key));
+         std::memcpy(kv.value.data() + sizeof(key), &id, sizeof(id));
+      });
+      // `by.id` rows live under the same table id, see find_account_by_id
+      db.create<chain::index64_object>([&](auto& idx) {
+         idx.t_id = t_id->id;
+         idx.primary_key = key;
+         idx.secondary_key = id;
+         idx.payer = src->payer;
+      });
+      db.modify(*t_id, [](auto& t) { ++t.count; });
+   }
+
+   size_t legacy_accounts() const {
+      size_t total = 0;
+      scan_accounts([&](account_object&&) {
+         ++total;
+         return false;
+      });
+      return total - account2_rows().size();
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(account_table_tests)
+
+BOOST_FIXTURE_TEST_CASE(accounts_are_keyed_by_address_hash, account_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   evm_eoa evm2;
+   transfer(evm1, evm2.address, 1_gwei);
+
+   auto rows = account2_rows();
+   BOOST_REQUIRE_EQUAL(rows.size(), 2);
+   BOOST_REQUIRE_EQUAL(legacy_accounts(), 0);
+
+   const auto& row1 = rows.at(account_key(evm1.address));
+   BOOST_CHECK_EQUAL(row1.id, 0);
+   BOOST_CHECK_EQUAL(row1.nonce, 1);
+   BOOST_CHECK(std::memcmp(row1.eth_address.data(), evm1.address.bytes, sizeof(evm1.address.bytes)) == 0);
+
+   const auto& row2 = rows.at(account_key(evm2.address));
+   BOOST_CHECK_EQUAL(row2.id, 1);
+   BOOST_CHECK_EQUAL(row2.nonce, 0);
+   BOOST_CHECK_EQUAL(*evm_balance(evm2), 1_gwei);
+   BOOST_CHECK_EQUAL(find_account_by_id(1)->address, evm2.address);
+
+   // Admin actions find accounts by id
+   freezeaccnt(1, true);
+   BOOST_CHECK(find_account_by_address(evm2.address)->has_flag(account_object::flag::frozen));
+   freezeaccnt(1, false);
+
+   addevmbal(1, 1_gwei, false);
+   BOOST_CHECK_EQUAL(*evm_balance(evm2), 2_gwei);
+   addevmbal(1, 1_gwei, true);
+
+   rmaccount(1);
+   BOOST_CHECK_EQUAL(account2_rows().size(), 1);
+   BOOST_CHECK(!find_account_by_address(evm2.address));
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(removed_accounts_shift_their_chain_in_place, account_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   const auto home = account_key(evm1.address);
+   plant_account2_row(home, home + 1, 99);
+   const auto* hole = find_account2_row(home);
+   BOOST_REQUIRE(hole);
+   const auto object_id = hole->id;
+   const auto payer = hole->payer;
+
+   // The planted row shares the home of evm1, so it moves back into the hole
+   rmaccount(0);
+   auto rows = account2_rows();
+   BOOST_REQUIRE_EQUAL(rows.size(), 1);
+   BOOST_CHECK_EQUAL(rows.at(home).id, 99);
+   BOOST_CHECK(!find_account2_row(home + 1));
+
+   // ... by modifying the row that was there, which keeps its payer
+   hole = find_account2_row(home);
+   BOOST_REQUIRE(hole);
+   BOOST_CHECK(hole->id == object_id);
+   BOOST_CHECK_EQUAL(hole->payer, payer);
+   BOOST_CHECK_EQUAL(find_account_by_id(99)->address, evm1.address);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(recreated_accounts_keep_their_row, account_table_tester) try {
+
+   evm_eoa evm2;
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   transfer(evm1, evm2.address, 1_gwei);
+   const auto before = account2_rows().at(account_key(evm2.address));
+   setkvstore(before.id, to_bytes(intx::uint256(1)), to_bytes(intx::uint256(11)));
+   freezeaccnt(before.id, true);
+
+   // A new incarnation gets a new id, so its storage starts empty
+   silkworm::Account initial{0, 1_gwei};
+   silkworm::Account current{0, 2_gwei};
+   current.incarnation = 1;
+   updateaccnt(evm2.address, initial, current);
+
+   auto rows = account2_rows();
+   BOOST_REQUIRE_EQUAL(rows.size(), 2);
+   const auto& after = rows.at(account_key(evm2.address));
+   BOOST_CHECK_EQUAL(after.id, before.id + 1);
+   BOOST_CHECK_EQUAL(*evm_balance(evm2), 2_gwei);
+   BOOST_CHECK_EQUAL(find_account_by_id(after.id)->address, evm2.address);
+   BOOST_CHECK(!find_account_by_id(before.id));
+   BOOST_CHECK(find_account_by_id(after.id)->has_flag(account_object::flag::frozen));
+
+   size_t slots = 0;
+   scan_account_storage(after.id, [&](storage_slot&&) {
+      ++slots;
+      return false;
+   });
+   BOOST_CHECK_EQUAL(slots, 0);
+   BOOST_CHECK_EQUAL(get_gcstore(0).storage_id, before.id);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(recreated_contracts_keep_their_constructor_storage, account_table_tester) try {
+
+   // Child: its constructor stores 42 in slot 0, its code selfdestructs to the caller
+   const std::string child_init = "602a6000556002601160003960026000f333ff";
+   // Factory: CREATE2 of the child with salt 0 on any call
+   const std::string factory_runtime = "601360126000396000601360006000f55000" + child_init;
+   const std::string factory_init = "6025600c60003960256000f3" + factory_runtime;
+
+   setversion(1, evm_account_name);
+   produce_blocks(2);
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   const auto factory = deploy_contract(evm1, evmc::from_hex(factory_init).value());
+
+   const auto init_code = evmc::from_hex(child_init).value();
+   const auto init_hash = ethash::keccak256(init_code.data(), init_code.size());
+   silkworm::Bytes preimage{0xff};
+   preimage += silkworm::Bytes{factory.bytes, sizeof(factory.bytes)};
+   preimage += silkworm::Bytes(32, 0);
+   preimage += silkworm::Bytes{init_hash.bytes, sizeof(init_hash.bytes)};
+   const auto preimage_hash = ethash::keccak256(preimage.data(), preimage.size());
+   evmc::address child;
+   std::memcpy(child.bytes, preimage_hash.bytes + 12, sizeof(child.bytes));
+
+   auto create = generate_tx(factory, 0, 1'000'000);
+   evm1.sign(create);
+   pushtx(create);
+   const auto first_id = find_account_by_address(child)->id;
+
+   // Destroyed and created again in one block, the second constructor writes the new scope
+   auto destroy = generate_tx(child, 0, 1'000'000);
+   evm1.sign(destroy);
+   auto recreate = generate_tx(factory, 0, 1'000'000);
+   evm1.sign(recreate);
+   pushtxs({destroy, recreate});
+
+   const auto account = find_account_by_address(child);
+   BOOST_REQUIRE(account);
+   BOOST_CHECK_NE(account->id, first_id);
+   std::map<intx::uint256, intx::uint256> storage;
+   scan_account_storage(account->id, [&](storage_slot&& slot) {
+      storage[slot.key] = slot.value;
+      return false;
+   });
+   BOOST_REQUIRE_EQUAL(storage.size(), 1);
+   BOOST_CHECK(storage.at(0) == 42);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(legacy_accounts_are_migrated, account_table_tester) try {
+
+   // Populate the legacy `account` table with the old contract
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm_0_5_1());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi_0_5_1().data());
+
+   evm_eoa evm2;
+   evm_eoa evm3;
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   transfer(evm1, evm2.address, 1_gwei);
+   transfer(evm1, evm3.address, 1_gwei);
+
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi().data());
+
+   BOOST_REQUIRE_EQUAL(legacy_accounts(), 3);
+   BOOST_REQUIRE(account2_rows().empty());
+
+   // Writing an account moves it, keeping its id
+   evm_eoa evm4;
+   transfer(evm2, evm4.address, 1);
+   BOOST_CHECK(migrated(evm2.address));
+   BOOST_CHECK(migrated(evm4.address));
+   BOOST_CHECK(!migrated(evm1.address));
+   BOOST_CHECK(!migrated(evm3.address));
+   BOOST_CHECK_EQUAL(find_account_by_address(evm2.address)->id, 1);
+   BOOST_CHECK_EQUAL(find_account_by_address(evm4.address)->id, 3);
+
+   // Not yet migrated accounts are still readable
+   BOOST_CHECK_EQUAL(*evm_balance(evm3), 1_gwei);
+   transfer(evm3, evm4.address, 1);
+
+   BOOST_REQUIRE_EXCEPTION(migrateacct(10, "alice"_n),
+      missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+   auto trace = migrateacct(10);
+   BOOST_CHECK(fc::raw::unpack<bool>(trace->action_traces[0].return_value));
+   BOOST_CHECK_EQUAL(legacy_accounts(), 0);
+   BOOST_CHECK(migrated(evm1.address));
+   BOOST_CHECK_EQUAL(find_account_by_address(evm1.address)->id, 0);
+   BOOST_CHECK_EQUAL(find_account_by_address(evm3.address)->id, 2);
+   BOOST_CHECK_EQUAL(*evm_balance(evm4), intx::uint256{2});
+
+   check_balances();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
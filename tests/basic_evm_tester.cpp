@@ -49,13 +49,6 @@ struct partial_account_table_row
    uint32_t flags;
 };
 
-struct storage_table_row
-{
-   uint64_t id;
-   bytes key;
-   bytes value;
-};
-
 } // namespace evm_test
 
 namespace fc { namespace raw {
@@ -93,13 +86,37 @@ namespace fc { namespace raw {
          fc::raw::unpack(ds, consensus_parameter);
          tmp.consensus_parameter.emplace(consensus_parameter);
       }
+      if(ds.remaining()) {
+         eosio::chain::name token_contract;
+         fc::raw::unpack(ds, token_contract);
+         tmp.token_contract.emplace(token_contract);
+      }
+      if(ds.remaining()) {
+         uint32_t gc_budget;
+         fc::raw::unpack(ds, gc_budget);
+         tmp.gc_budget.emplace(gc_budget);
+      }
+      if(ds.remaining()) {
+         uint32_t max_inline_erase_slots;
+         fc::raw::unpack(ds, max_inline_erase_slots);
+         tmp.max_inline_erase_slots.emplace(max_inline_erase_slots);
+      }
+      if(ds.remaining()) {
+         uint64_t next_price_block;
+         fc::raw::unpack(ds, next_price_block);
+         tmp.next_price_block.emplace(next_price_block);
+      }
+      if(ds.remaining()) {
+         uint32_t event_flags;
+         fc::raw::unpack(ds, event_flags);
+         tmp.event_flags.emplace(event_flags);
+      }
     } FC_RETHROW_EXCEPTIONS(warn, "error unpacking partial_account_table_row") }
 }}
 
 
 FC_REFLECT(evm_test::vault_balance_row, (owner)(balance)(dust))
 FC_REFLECT(evm_test::partial_account_table_row, (id)(eth_address)(nonce)(balance)(code_id)(flags))
-FC_REFLECT(evm_test::storage_table_row, (id)(key)(value))
 
 namespace evm_test {
 
@@ -437,6 +454,22 @@ transaction_trace_ptr basic_evm_tester::pushtx(const silkworm::Transaction& trx,
    }
 }
 
+transaction_trace_ptr basic_evm_tester::pushtxs(const std::vector<silkworm::Transaction>& trxs, name miner, std::optional<uint64_t> min_inclusion_price)
+{
+   std::vector<bytes> rlptxs;
+   for (const auto& trx : trxs) {
+      silkworm::Bytes rlp;
+      silkworm::rlp::encode(rlp, trx);
+      rlptxs.emplace_back(rlp.begin(), rlp.end());
+   }
+
+   if (min_inclusion_price.has_value()) {
+      return push_action(evm_account_name, "pushtxs"_n, miner, mvo()("miner", miner)("rlptxs", rlptxs)("min_inclusion_price", min_inclusion_price));
+   } else {
+      return push_action(evm_account_name, "pushtxs"_n, miner, mvo()("miner", miner)("rlptxs", rlptxs));
+   }
+}
+
 transaction_trace_ptr basic_evm_tester::setversion(uint64_t version, name actor) {
    return basic_evm_tester::push_action(evm_account_name, "setversion"_n, actor,
       mvo()("version", version));
@@ -460,6 +493,31 @@ transaction_trace_ptr basic_evm_tester::setgasparam(uint64_t gas_txnewaccount,
            ("gas_sset", gas_sset));
 }
 
+transaction_trace_ptr basic_evm_tester::migratecode(uint32_t max, name actor) {
+   return basic_evm_tester::push_action(evm_account_name, "migratecode"_n, actor,
+      mvo()("max", max));
+}
+
+transaction_trace_ptr basic_evm_tester::migratestor(uint32_t max, name actor) {
+   return basic_evm_tester::push_action(evm_account_name, "migratestor"_n, actor,
+      mvo()("max", max));
+}
+
+transaction_trace_ptr basic_evm_tester::migrateacct(uint32_t max, name actor) {
+   return basic_evm_tester::push_action(evm_account_name, "migrateacct"_n, actor,
+      mvo()("max", max));
+}
+
+transaction_trace_ptr basic_evm_tester::migratevault(uint32_t max, name actor) {
+   return basic_evm_tester::push_action(evm_account_name, "migratevault"_n, actor,
+      mvo()("max", max));
+}
+
+transaction_trace_ptr basic_evm_tester::setevents(uint32_t flags, name actor) {
+   return basic_evm_tester::push_action(evm_account_name, "setevents"_n, actor,
+      mvo()("flags", flags));
+}
+
 transaction_trace_ptr basic_evm_tester::rmgcstore(uint64_t id, name actor) {
    return basic_evm_tester::push_action(evm_account_name, "rmgcstore"_n, actor,
       mvo()("id", id));
@@ -514,6 +572,13 @@ evmc::address basic_evm_tester::deploy_contract(evm_eoa& eoa, evmc::bytes byteco
    return silkworm::create_address(eoa.address, nonce);
 }
 
+faucet_evm_tester::faucet_evm_tester() :
+   faucet_eoa(evmc::from_hex("a3f1b69da92a0233ce29485d3049a4ace39e8d384bbc2557e3fc60940ce4e954").value())
+{
+   init();
+   transfer_token(faucet_account_name, evm_account_name, make_asset(100'0000), faucet_eoa.address_0x());
+}
+
 void basic_evm_tester::addegress(const std::vector<name>& accounts)
 {
    push_action(evm_account_name, "addegress"_n, evm_account_name, mvo()("accounts", accounts));
@@ -537,12 +602,23 @@ balance_and_dust basic_evm_tester::inevm() const {
    return fc::raw::unpack<balance_and_dust>(get_row_by_account(evm_account_name, evm_account_name, "inevm"_n, "inevm"_n));
 }
 
-void basic_evm_tester::gc(uint32_t max) {
-   push_action(evm_account_name, "gc"_n, evm_account_name, mvo()("max", max));
+transaction_trace_ptr basic_evm_tester::gc(uint32_t max) {
+   return push_action(evm_account_name, "gc"_n, evm_account_name, mvo()("max", max));
+}
+
+transaction_trace_ptr basic_evm_tester::gcbacklog(uint32_t max_entries, uint32_t max_rows) {
+   return push_action(evm_account_name, "gcbacklog"_n, evm_account_name,
+      mvo()("max_entries", max_entries)("max_rows", max_rows));
 }
 
 balance_and_dust basic_evm_tester::vault_balance(name owner) const
 {
+   // Owners not looked up since `vaults` was added are still in the legacy `balances` table
+   if (const vector<char> d = get_row_by_account(evm_account_name, evm_account_name, "vaults"_n, owner); d.size()) {
+      auto row = fc::raw::unpack<vault_table_row>(d);
+      FC_ASSERT(row.open, "EVM not open");
+      return {.balance = row.balance, .dust = row.dust};
+   }
    const vector<char> d = get_row_by_account(evm_account_name, evm_account_name, "balances"_n, owner);
    FC_ASSERT(d.size(), "EVM not open");
    auto [_, amount, dust] = fc::raw::unpack<vault_balance_row>(d);
@@ -589,11 +665,44 @@ std::optional<account_object> convert_to_account_object(const partial_account_ta
    };
 }
 
+account_object convert_to_account_object(const account2_table_row& row)
+{
+   evmc::address address;
+   std::memcpy(address.bytes, row.eth_address.data(), sizeof(address.bytes));
+
+   return account_object{
+      .id = row.id,
+      .address = std::move(address),
+      .nonce = row.nonce,
+      .balance = intx::be::unsafe::load<intx::uint256>(reinterpret_cast<const uint8_t*>(row.balance.data())),
+      .code_id = row.code_id,
+      .flags = row.flags
+   };
+}
+
+uint64_t basic_evm_tester::account_key(const evmc::address& address)
+{
+   const auto hash = ethash::keccak256(address.bytes, sizeof(address.bytes));
+   return intx::be::unsafe::load<uint64_t>(hash.bytes);
+}
+
 bool basic_evm_tester::scan_accounts(std::function<bool(account_object)> visitor) const
 {
    static constexpr eosio::chain::name account_table_name = "account"_n;
+   static constexpr eosio::chain::name account2_table_name = "account2"_n;
 
    bool successful = true;
+   bool stopped = false;
+
+   scan_table<account2_table_row>(
+      account2_table_name, evm_account_name, [&visitor, &stopped](account2_table_row&& row) {
+         stopped = visitor(convert_to_account_object(row));
+         return stopped;
+      });
+
+   if (stopped) {
+      return successful;
+   }
 
    scan_table<partial_account_table_row>(
       account_table_name, evm_account_name, [this, &visitor, &successful](partial_account_table_row&& row) {
@@ -627,11 +736,26 @@ std::optional<account_object> basic_evm_tester::scan_for_account_by_address(cons
 std::optional<account_object> basic_evm_tester::find_account_by_address(const evmc::address& address) const
 {
    static constexpr eosio::chain::name account_table_name = "account"_n;
+   static constexpr eosio::chain::name account2_table_name = "account2"_n;
 
    std::optional<account_object> result;
 
    const auto& db = control->db();
 
+   if (const auto* t2_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+          boost::make_tuple(evm_account_name, evm_account_name, account2_table_name))) {
+      for (uint64_t key = account_key(address);; ++key) {
+         const auto* row = db.find<chain::key_value_object, chain::by_scope_primary>(boost::make_tuple(t2_id->id, key));
+         if (!row) {
+            break;
+         }
+         auto account = convert_to_account_object(fc::raw::unpack<account2_table_row>(row->value.data(), row->value.size()));
+         if (account.address == address) {
+            return account;
+         }
+      }
+   }
+
    const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
       boost::make_tuple(evm_account_name, evm_account_name, account_table_name));
 
@@ -670,6 +794,22 @@ std::optional<account_object> basic_evm_tester::find_account_by_address(const ev
 std::optional<account_object> basic_evm_tester::find_account_by_id(uint64_t id) const
 {
    static constexpr eosio::chain::name account_table_name = "account"_n;
+   static constexpr eosio::chain::name account2_table_name = "account2"_n;
+
+   const auto& db = control->db();
+
+   // `by.id` rows are stored under the same table id as `account2` rows
+   if (const auto* t2_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+          boost::make_tuple(evm_account_name, evm_account_name, account2_table_name))) {
+      if (const auto* secondary_row = db.find<chain::index64_object, chain::by_secondary>(boost::make_tuple(t2_id->id, id))) {
+         const auto* row = db.find<chain::key_value_object, chain::by_scope_primary>(
+            boost::make_tuple(t2_id->id, secondary_row->primary_key));
+         if (row) {
+            return convert_to_account_object(fc::raw::unpack<account2_table_row>(row->value.data(), row->value.size()));
+         }
+      }
+   }
+
    const vector<char> d =
       get_row_by_account(evm_account_name, evm_account_name, account_table_name, name{id});
    if(d.empty()) return {};
@@ -702,8 +842,23 @@ intx::uint128 basic_evm_tester::tx_data_cost(const silkworm::Transaction& txn) c
 bool basic_evm_tester::scan_account_storage(uint64_t account_id, std::function<bool(storage_slot)> visitor) const
 {
    static constexpr eosio::chain::name storage_table_name = "storage"_n;
+   static constexpr eosio::chain::name storage2_table_name = "storage2"_n;
 
    bool successful = true;
+   bool stopped = false;
+
+   scan_table<storage2_table_row>(
+      storage2_table_name, name{account_id}, [&visitor, &stopped](storage2_table_row&& row) {
+         if (row.value.empty()) {
+            return false;
+         }
+         stopped = visitor(storage_slot{.id = row.id, .key = row.get_key(), .value = row.get_value()});
+         return stopped;
+      });
+
+   if (stopped) {
+      return successful;
+   }
 
    scan_table<storage_table_row>(
       storage_table_name, name{account_id}, [&visitor, &successful](storage_table_row&& row) {
@@ -721,7 +876,21 @@ bool basic_evm_tester::scan_account_storage(uint64_t account_id, std::function<b
 }
 
 void basic_evm_tester::scan_balances(std::function<bool(vault_balance_row)> visitor) const {
+   static constexpr eosio::chain::name vaults_table_name = "vaults"_n;
    static constexpr eosio::chain::name balances_table_name = "balances"_n;
+   bool stopped = false;
+   scan_table<vault_table_row>(
+      vaults_table_name, evm_account_name, [&visitor, &stopped](vault_table_row&& row) {
+         if (!row.open) {
+            return false;
+         }
+         stopped = visitor(vault_balance_row{.owner = row.owner, .balance = row.balance, .dust = row.dust});
+         return stopped;
+      }
+   );
+   if (stopped) {
+      return;
+   }
    scan_table<vault_balance_row>(
       balances_table_name, evm_account_name, [this, &visitor](vault_balance_row&& row) {
          return visitor(row);
@@ -741,6 +910,36 @@ bool basic_evm_tester::scan_gcstore(std::function<bool(gcstore)> visitor) const
 }
 
 bool basic_evm_tester::scan_account_code(std::function<bool(account_code)> visitor) const
+{
+   static constexpr eosio::chain::name code_meta_table_name = "codemeta"_n;
+   static constexpr eosio::chain::name code_blob_table_name = "codeblob"_n;
+
+   std::map<uint64_t, bytes> blobs;
+   scan_table<code_blob_row>(
+      code_blob_table_name, evm_account_name, [&blobs](code_blob_row&& row) {
+         blobs[row.id] = std::move(row.code);
+         return false;
+      }
+   );
+
+   bool stopped = false;
+   scan_table<code_meta_row>(
+      code_meta_table_name, evm_account_name, [&](code_meta_row&& row) {
+         auto itr = blobs.find(row.id);
+         BOOST_REQUIRE(itr != blobs.end());
+         stopped = visitor(account_code{row.id, row.ref_count, itr->second, row.code_hash});
+         return stopped;
+      }
+   );
+
+   if (!stopped) {
+      scan_legacy_account_code(visitor);
+   }
+
+   return true;
+}
+
+bool basic_evm_tester::scan_legacy_account_code(std::function<bool(account_code)> visitor) const
 {
    static constexpr eosio::chain::name account_code_table_name = "accountcode"_n;
 
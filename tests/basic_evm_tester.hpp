@@ -60,7 +60,57 @@ struct evmtx_v0 {
    uint64_t  base_fee_per_gas;
 };
 
-using evmtx_type = std::variant<evmtx_v0>;
+struct evmtx_v1 {
+   uint64_t           eos_evm_version;
+   uint64_t           base_fee_per_gas;
+   uint32_t           tx_count;
+   std::vector<bytes> rlptxs;
+   std::vector<bytes> rlp_hashes;
+};
+
+using evmtx_type = std::variant<evmtx_v0, evmtx_v1>;
+
+struct account_change {
+   bytes                   address;
+   std::optional<uint64_t> nonce;
+   bytes                   balance;
+   bool                    fresh;
+};
+
+struct code_change {
+   bytes    address;
+   uint64_t code_id;
+   bytes    code_hash;
+};
+
+struct storage_change {
+   bytes address;
+   bytes key;
+   bytes value;
+};
+
+struct log_entry {
+   bytes              address;
+   std::vector<bytes> topics;
+   bytes              data;
+};
+
+struct tx_result {
+   bool                   success;
+   uint64_t               gas_used;
+   std::vector<log_entry> logs;
+};
+
+struct statediff_v0 {
+   uint64_t                    eos_evm_version;
+   uint64_t                    block_num;
+   std::vector<tx_result>      txs;
+   std::vector<account_change> accounts;
+   std::vector<code_change>    codes;
+   std::vector<storage_change> storage;
+};
+
+using statediff_type = std::variant<statediff_v0>;
 
 struct evm_version_type {
    struct pending {
@@ -101,6 +151,11 @@ struct config_table_row
    uint32_t status;
    std::optional<evm_version_type> evm_version;
    std::optional<consensus_parameter_type> consensus_parameter;
+   std::optional<name> token_contract;
+   std::optional<uint32_t> gc_budget;
+   std::optional<uint32_t> max_inline_erase_slots;
+   std::optional<uint64_t> next_price_block;
+   std::optional<uint32_t> event_flags;
 };
 
 struct config2_table_row
@@ -198,6 +253,67 @@ struct account_code {
     bytes       code_hash;
 };
 
+struct code_meta_row {
+    uint64_t    id;
+    uint32_t    ref_count;
+    bytes       code_hash;
+};
+
+struct code_analysis {
+    uint32_t    version;
+    bytes       jumpdests;
+};
+
+struct code_blob_row {
+    uint64_t      id;
+    bytes         code;
+    code_analysis analysis;
+};
+
+struct account2_table_row
+{
+   uint64_t key;
+   uint64_t id;
+   fc::ripemd160 eth_address;
+   uint64_t nonce;
+   fc::sha256 balance;
+   std::optional<uint64_t> code_id;
+   uint32_t flags;
+};
+
+struct storage_table_row
+{
+   uint64_t id;
+   bytes key;
+   bytes value;
+};
+
+struct vault_table_row
+{
+   name owner;
+   asset balance{};
+   uint64_t dust = 0;
+   uint64_t next_nonce = 0;
+   bool open = true;
+};
+
+struct storage2_table_row
+{
+   uint64_t id;
+   bytes key;   // without leading zero bytes
+   bytes value; // without leading zero bytes, empty when the row is free
+
+   static intx::uint256 load(const bytes& data) {
+      uint8_t buffer[32] = {};
+      BOOST_REQUIRE(data.size() <= sizeof(buffer));
+      std::memcpy(buffer + sizeof(buffer) - data.size(), data.data(), data.size());
+      return intx::be::load<intx::uint256>(buffer);
+   }
+
+   intx::uint256 get_key() const { return load(key); }
+   intx::uint256 get_value() const { return load(value); }
+};
+
 using bridge_message = std::variant<bridge_message_v0>;
 
 struct price_queue {
@@ -224,7 +340,21 @@ FC_REFLECT(evm_test::message_receiver, (account)(handler)(min_fee)(flags));
 FC_REFLECT(evm_test::bridge_message_v0, (receiver)(sender)(timestamp)(value)(data));
 FC_REFLECT(evm_test::gcstore, (id)(storage_id));
 FC_REFLECT(evm_test::account_code, (id)(ref_count)(code)(code_hash));
+FC_REFLECT(evm_test::code_meta_row, (id)(ref_count)(code_hash));
+FC_REFLECT(evm_test::code_analysis, (version)(jumpdests));
+FC_REFLECT(evm_test::code_blob_row, (id)(code)(analysis));
+FC_REFLECT(evm_test::account2_table_row, (key)(id)(eth_address)(nonce)(balance)(code_id)(flags));
+FC_REFLECT(evm_test::storage_table_row, (id)(key)(value));
+FC_REFLECT(evm_test::storage2_table_row, (id)(key)(value));
+FC_REFLECT(evm_test::vault_table_row, (owner)(balance)(dust)(next_nonce)(open));
 FC_REFLECT(evm_test::evmtx_v0, (eos_evm_version)(rlptx)(base_fee_per_gas));
+FC_REFLECT(evm_test::evmtx_v1, (eos_evm_version)(base_fee_per_gas)(tx_count)(rlptxs)(rlp_hashes));
+FC_REFLECT(evm_test::account_change, (address)(nonce)(balance)(fresh));
+FC_REFLECT(evm_test::code_change, (address)(code_id)(code_hash));
+FC_REFLECT(evm_test::storage_change, (address)(key)(value));
+FC_REFLECT(evm_test::log_entry, (address)(topics)(data));
+FC_REFLECT(evm_test::tx_result, (success)(gas_used)(logs));
+FC_REFLECT(evm_test::statediff_v0, (eos_evm_version)(block_num)(txs)(accounts)(codes)(storage));
 
 FC_REFLECT(evm_test::consensus_parameter_type, (current)(pending));
 FC_REFLECT(evm_test::pending_consensus_parameter_data_type, (data)(pending_time));
@@ -435,6 +565,7 @@ public:
    transaction_trace_ptr exec(const exec_input& input, const std::optional<exec_callback>& callback);
    transaction_trace_ptr assertnonce(name account, uint64_t next_nonce);
    transaction_trace_ptr pushtx(const silkworm::Transaction& trx, name miner = evm_account_name, std::optional<uint64_t> min_inclusion_price={});
+   transaction_trace_ptr pushtxs(const std::vector<silkworm::Transaction>& trxs, name miner = evm_account_name, std::optional<uint64_t> min_inclusion_price={});
    transaction_trace_ptr setversion(uint64_t version, name actor);
    transaction_trace_ptr call(name from, const evmc::bytes& to, const evmc::bytes& value, evmc::bytes& data, uint64_t gas_limit, name actor);
    transaction_trace_ptr admincall(const evmc::bytes& from, const evmc::bytes& to, const evmc::bytes& value, evmc::bytes& data, uint64_t gas_limit, name actor);
@@ -449,6 +580,11 @@ public:
    void addegress(const std::vector<name>& accounts);
    void removeegress(const std::vector<name>& accounts);
 
+   transaction_trace_ptr migratecode(uint32_t max, name actor=evm_account_name);
+   transaction_trace_ptr migratestor(uint32_t max, name actor=evm_account_name);
+   transaction_trace_ptr migrateacct(uint32_t max, name actor=evm_account_name);
+   transaction_trace_ptr migratevault(uint32_t max, name actor=evm_account_name);
+   transaction_trace_ptr setevents(uint32_t flags, name actor=evm_account_name);
    transaction_trace_ptr rmgcstore(uint64_t id, name actor=evm_account_name);
    transaction_trace_ptr setkvstore(uint64_t account_id, const bytes& key, const std::optional<bytes>& value, name actor=evm_account_name);
    transaction_trace_ptr rmaccount(uint64_t id, name actor=evm_account_name);
@@ -461,7 +597,8 @@ public:
    void withdraw(name owner, asset quantity);
 
    balance_and_dust inevm() const;
-   void gc(uint32_t max);
+   transaction_trace_ptr gc(uint32_t max);
+   transaction_trace_ptr gcbacklog(uint32_t max_entries, uint32_t max_rows);
    balance_and_dust vault_balance(name owner) const;
    std::optional<intx::uint256> evm_balance(const evmc::address& address) const;
    std::optional<intx::uint256> evm_balance(const evm_eoa& account) const;
@@ -495,19 +632,33 @@ public:
       }
    }
 
+   // Home key of an address in `account2`
+   static uint64_t account_key(const evmc::address& address);
+   // Visits accounts from `account2` followed by not yet migrated `account` rows
    bool scan_accounts(std::function<bool(account_object)> visitor) const;
    std::optional<account_object> scan_for_account_by_address(const evmc::address& address) const;
    std::optional<account_object> find_account_by_address(const evmc::address& address) const;
    std::optional<account_object> find_account_by_id(uint64_t id) const;
+   // Visits slots from `storage2` followed by not yet migrated `storage` rows
    bool scan_account_storage(uint64_t account_id, std::function<bool(storage_slot)> visitor) const;
    bool scan_gcstore(std::function<bool(gcstore)> visitor) const;
+   // Visits codes from `codemeta`/`codeblob` followed by not yet migrated `accountcode` rows
    bool scan_account_code(std::function<bool(account_code)> visitor) const;
+   bool scan_legacy_account_code(std::function<bool(account_code)> visitor) const;
    void scan_balances(std::function<bool(evm_test::vault_balance_row)> visitor) const;
    bool scan_price_queue(std::function<bool(evm_test::price_queue)> visitor) const;
 
    intx::uint128 tx_data_cost(const silkworm::Transaction& txn) const;
 };
 
+// Initialized contract with `faucet_eoa` funded, for tests that only need one EVM sender
+struct faucet_evm_tester : basic_evm_tester
+{
+   evm_eoa faucet_eoa;
+
+   faucet_evm_tester();
+};
+
 inline constexpr intx::uint256 operator"" _wei(const char* s) { return intx::from_string<intx::uint256>(s); }
 
 inline constexpr intx::uint256 operator"" _kwei(const char* s)
@@ -0,0 +1,234 @@
+#include "basic_evm_tester.hpp"
+
+using namespace evm_test;
+
+struct code_table_tester : basic_evm_tester {
+   // Same Factory/TestContract pair as account_id_tests:
+   //   Factory::deploy(bytes32 salt)   creates TestContract with CREATE2
+   //   TestContract::set_foo(uint val) stores val in slot 0
+   //   TestContract::killme()          self destructs
+   const std::string factory_and_test_bytecode = "608060405234801561001057600080fd5b506102c1806100206000396000f3fe60806040526004361061001e5760003560e01c80632b85ba3814610023575b600080fd5b61003d600480360381019061003891906100d2565b610053565b60405161004a9190610140565b60405180910390f35b6000816040516100629061008a565b8190604051809103906000f5905080158015610082573d6000803e3d6000fd5b509050919050565b6101308061015c83390190565b600080fd5b6000819050919050565b6100af8161009c565b81146100ba57600080fd5b50565b6000813590506100cc816100a6565b92915050565b6000602082840312156100e8576100e7610097565b5b60006100f6848285016100bd565b91505092915050565b600073ffffffffffffffffffffffffffffffffffffffff82169050919050565b600061012a826100ff565b9050919050565b61013a8161011f565b82525050565b60006020820190506101556000830184610131565b9291505056fe608060405234801561001057600080fd5b50610110806100206000396000f3fe6080604052348015600f57600080fd5b506004361060325760003560e01c806324d97a4a146037578063e5d5dfbc14603f575b600080fd5b603d6057565b005b605560048036038101906051919060b2565b6072565b005b60008073ffffffffffffffffffffffffffffffffffffffff16ff5b8060008190555050565b600080fd5b6000819050919050565b6092816081565b8114609c57600080fd5b50565b60008135905060ac81608b565b92915050565b60006020828403121560c55760c4607c565b5b600060d184828501609f565b9150509291505056fea2646970667358221220e59ba0023d9a6f99a6734000d8812c1830a2a61597b322310827ec350a4304dd64736f6c63430008120033a26469706673582212205e94c73549f6e1751509ff5704aec0a8ada3a60ab2b8cc1b9df9febc7ed2bd2f64736f6c63430008120033";
+
+   evm_eoa evm1;
+
+   code_table_tester() {
+      create_accounts({"alice"_n});
+      transfer_token(faucet_account_name, "alice"_n, make_asset(10000'0000));
+      init();
+   }
+
+   void call_contract(const evmc::address& to, const silkworm::Bytes& data) {
+      auto txn = generate_tx(to, 0, 1'000'000);
+      txn.data = data;
+      evm1.sign(txn);
+      pushtx(txn);
+   }
+
+   void factory_deploy(const evmc::address& factory, uint64_t salt) {
+      silkworm::Bytes data;
+      data += evmc::from_hex("2b85ba38").value(); // deploy
+      data += evmc::bytes32{salt};
+      call_contract(factory, data);
+   }
+
+   void set_foo(const evmc::address& test_contract, uint64_t val) {
+      silkworm::Bytes data;
+      data += evmc::from_hex("e5d5dfbc").value(); // set_foo
+      data += evmc::bytes32{val};
+      call_contract(test_contract, data);
+   }
+
+   void killme(const evmc::address& test_contract) {
+      call_contract(test_contract, evmc::from_hex("24d97a4a").value());
+   }
+
+   std::map<uint64_t, code_meta_row> code_metas() const {
+      std::map<uint64_t, code_meta_row> res;
+      scan_table<code_meta_row>("codemeta"_n, evm_account_name, [&](code_meta_row&& row) {
+         res[row.id] = row;
+         return false;
+      });
+      return res;
+   }
+
+   std::map<uint64_t, account_code> legacy_codes() const {
+      std::map<uint64_t, account_code> res;
+      scan_legacy_account_code([&](account_code row) {
+         res[row.id] = row;
+         return false;
+      });
+      return res;
+   }
+
+   size_t total_code_blobs() const {
+      size_t total = 0;
+      scan_table<code_blob_row>("codeblob"_n, evm_account_name, [&](code_blob_row&&) {
+         ++total;
+         return false;
+      });
+      return total;
+   }
+
+   std::map<uint64_t, code_blob_row> code_blobs() const {
+      std::map<uint64_t, code_blob_row> res;
+      scan_table<code_blob_row>("codeblob"_n, evm_account_name, [&](code_blob_row&& row) {
+         res[row.id] = row;
+         return false;
+      });
+      return res;
+   }
+
+   // Init code returning `runtime` (at most 64KiB)
+   static silkworm::Bytes make_init_code(const silkworm::Bytes& runtime) {
+      const auto size = static_cast<uint16_t>(runtime.size());
+      silkworm::Bytes init{0x61, uint8_t(size >> 8), uint8_t(size), // PUSH2 size
+                           0x60, 0x0e,                               // PUSH1 14 (runtime offset)
+                           0x60, 0x00,                               // PUSH1 0
+                           0x39,                                     // CODECOPY
+                           0x61, uint8_t(size >> 8), uint8_t(size), // PUSH2 size
+                           0x60, 0x00,                               // PUSH1 0
+                           0xf3};                                    // RETURN
+      return init + runtime;
+   }
+
+   int32_t exec_status(const evmc::address& to) {
+      exec_input input;
+      input.to = bytes{std::begin(to.bytes), std::end(to.bytes)};
+      auto trace = exec(input, {});
+      return fc::raw::unpack<exec_output>(trace->action_traces[0].return_value).status;
+   }
+
+   size_t get_storage_slots_count(uint64_t account_id) const {
+      size_t total_slots{0};
+      scan_account_storage(account_id, [&](const storage_slot& slot) -> bool {
+         total_slots++;
+         return false;
+      });
+      return total_slots;
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(code_table_tests)
+
+BOOST_FIXTURE_TEST_CASE(code_is_split_into_meta_and_blob, code_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   auto factory = deploy_contract(evm1, evmc::from_hex(factory_and_test_bytecode).value());
+
+   factory_deploy(factory, 555);
+   factory_deploy(factory, 556);
+
+   BOOST_REQUIRE(legacy_codes().empty());
+   auto metas = code_metas();
+   BOOST_REQUIRE_EQUAL(metas.size(), 2);
+   BOOST_REQUIRE_EQUAL(total_code_blobs(), 2);
+
+   auto test_contract = find_account_by_id(2).value();
+   BOOST_REQUIRE_EQUAL(metas.at(*test_contract.code_id).ref_count, 2);
+
+   // Code is still readable from the blob table
+   set_foo(test_contract.address, 1234);
+   BOOST_CHECK_EQUAL(get_storage_slots_count(test_contract.id), 1);
+
+   // Releasing one reference only touches the metadata row
+   killme(test_contract.address);
+   BOOST_CHECK_EQUAL(code_metas().at(*test_contract.code_id).ref_count, 1);
+   BOOST_CHECK_EQUAL(total_code_blobs(), 2);
+
+   // Releasing the last one removes both rows
+   killme(find_account_by_id(3).value().address);
+   BOOST_CHECK_EQUAL(code_metas().size(), 1);
+   BOOST_CHECK_EQUAL(total_code_blobs(), 1);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(legacy_codes_are_migrated, code_table_tester) try {
+
+   // Populate the legacy `accountcode` table with the old contract
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm_0_5_1());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi_0_5_1().data());
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   auto factory = deploy_contract(evm1, evmc::from_hex(factory_and_test_bytecode).value());
+   factory_deploy(factory, 555);
+   factory_deploy(factory, 556);
+
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi().data());
+
+   const auto factory_code_id = *find_account_by_address(factory)->code_id;
+   const auto test_contract = find_account_by_id(2).value();
+   const auto test_code_id = *test_contract.code_id;
+
+   auto legacy = legacy_codes();
+   BOOST_REQUIRE_EQUAL(legacy.size(), 2);
+   BOOST_REQUIRE_EQUAL(legacy.at(test_code_id).ref_count, 2);
+   BOOST_REQUIRE(code_metas().empty());
+
+   // Legacy code can be executed without being migrated
+   set_foo(test_contract.address, 1234);
+   BOOST_CHECK_EQUAL(get_storage_slots_count(test_contract.id), 1);
+   BOOST_CHECK_EQUAL(legacy_codes().size(), 2);
+
+   // Deploying the same code again moves the row, keeping its id
+   factory_deploy(factory, 557);
+   BOOST_CHECK_EQUAL(legacy_codes().size(), 1);
+   auto metas = code_metas();
+   BOOST_REQUIRE_EQUAL(metas.size(), 1);
+   BOOST_CHECK_EQUAL(metas.at(test_code_id).ref_count, 3);
+   BOOST_CHECK(metas.at(test_code_id).code_hash == legacy.at(test_code_id).code_hash);
+
+   // The rest is migrated by the action
+   auto trace = migratecode(10);
+   BOOST_CHECK(fc::raw::unpack<bool>(trace->action_traces[0].return_value));
+   BOOST_CHECK(legacy_codes().empty());
+
+   metas = code_metas();
+   BOOST_REQUIRE_EQUAL(metas.size(), 2);
+   BOOST_CHECK_EQUAL(metas.at(factory_code_id).ref_count, 1);
+   BOOST_CHECK(metas.at(factory_code_id).code_hash == legacy.at(factory_code_id).code_hash);
+
+   size_t codes_seen = 0;
+   scan_account_code([&](account_code row) {
+      BOOST_CHECK(row.code == legacy.at(row.id).code);
+      ++codes_seen;
+      return false;
+   });
+   BOOST_CHECK_EQUAL(codes_seen, 2);
+
+   // Migrated code is still executable and new code ids don't collide with migrated ones
+   factory_deploy(factory, 558);
+   deploy_contract(evm1, evmc::from_hex("6001600c60003960016000f300").value());
+   metas = code_metas();
+   BOOST_CHECK_EQUAL(metas.size(), 3);
+   BOOST_CHECK_EQUAL(metas.at(test_code_id).ref_count, 4);
+
+   BOOST_REQUIRE_EXCEPTION(migratecode(10, "alice"_n),
+                           missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(jumpdest_analysis_is_persisted, code_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+
+   // PUSH1 4, JUMP, STOP, JUMPDEST, STOP
+   auto valid = deploy_contract(evm1, make_init_code(evmc::from_hex("600456005b00").value()));
+   // PUSH1 4, JUMP, PUSH1 0x5b, STOP: offset 4 is PUSH data
+   auto invalid = deploy_contract(evm1, make_init_code(evmc::from_hex("600456605b00").value()));
+
+   auto blobs = code_blobs();
+   const auto& valid_analysis = blobs.at(*find_account_by_address(valid)->code_id).analysis;
+   BOOST_CHECK_EQUAL(valid_analysis.version, 1);
+   BOOST_CHECK(valid_analysis.jumpdests == bytes{0x10});
+
+   const auto& invalid_analysis = blobs.at(*find_account_by_address(invalid)->code_id).analysis;
+   BOOST_CHECK_EQUAL(invalid_analysis.version, 1);
+   BOOST_CHECK(invalid_analysis.jumpdests == bytes{0x00});
+
+   BOOST_CHECK_EQUAL(exec_status(valid), 0);
+   BOOST_CHECK_NE(exec_status(invalid), 0);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -34,6 +34,7 @@
 #include <nlohmann/json.hpp>
 #include <ethash/keccak.hpp>
 #include <magic_enum.hpp>
+#include <secp256k1_recovery.h>
 
 using namespace eosio_system;
 using namespace eosio;
@@ -136,6 +137,24 @@ static std::optional<Object> get_by_primary_key(chainbase::database& db, const n
    );
 }
 
+template <typename T, typename Object>
+static std::optional<Object> find_by_primary_key(chainbase::database& db, const name& scope, const T& o) {
+   const auto& tab = find_or_create_table(
+      db, "evm"_n, scope, Object::table_name(), "evm"_n
+   );
+
+   const auto* kv_obj = db.find<key_value_object, by_scope_primary>(
+      boost::make_tuple(tab.id, o)
+   );
+
+   if( kv_obj == nullptr ) return {};
+
+   return fc::raw::unpack<Object>(
+      kv_obj->value.data(),
+      kv_obj->value.size()
+   );
+}
+
 template <typename T, typename Object>
 static std::optional<Object> get_by_index(chainbase::database& db, const name& scope, const name& inx, const T& o) {
    
@@ -250,6 +269,28 @@ struct block_info {
 //FC_REFLECT(block_info, (coinbase)(difficulty)(gasLimit)(number)(timestamp)(base_fee_per_gas));
 FC_REFLECT(block_info, (coinbase)(difficulty)(gasLimit)(number)(timestamp));
 
+struct account2 {
+   uint64_t      key;
+   uint64_t      id;
+   fc::ripemd160 eth_address;
+   uint64_t      nonce;
+   fc::sha256    balance;
+   std::optional<uint64_t> code_id;
+   uint32_t      flags;
+
+   static name table_name() { return "account2"_n; }
+
+   // Same key as the one derived by the contract, collisions probe the following keys
+   static std::optional<account2> get_by_address(chainbase::database& db, const evmc::address& address) {
+      const auto hash = ethash::keccak256(address.bytes, sizeof(address.bytes));
+      for (uint64_t key = intx::be::unsafe::load<uint64_t>(hash.bytes);; ++key) {
+         auto row = find_by_primary_key<uint64_t, account2>(db, "evm"_n, key);
+         if (!row || memcmp(row->eth_address.data(), address.bytes, sizeof(address.bytes)) == 0) return row;
+      }
+   }
+};
+FC_REFLECT(account2, (key)(id)(eth_address)(nonce)(balance)(code_id)(flags));
+
 struct account {
    uint64_t    id;
    bytes       eth_address;
@@ -283,6 +324,14 @@ struct account {
    }
 
    static std::optional<account> get_by_address(chainbase::database& db, const evmc::address& address) {
+      if (auto r2 = account2::get_by_address(db, address)) {
+         return account{
+            .id = r2->id,
+            .eth_address = bytes{r2->eth_address.data(), r2->eth_address.data() + r2->eth_address.data_size()},
+            .nonce = r2->nonce,
+            .balance = bytes{r2->balance.data(), r2->balance.data() + r2->balance.data_size()},
+            .code_id = r2->code_id};
+      }
       auto r = get_by_index<evmc::address, account>(db, "evm"_n, "by.address"_n, address);
       return r;
    }
@@ -329,6 +378,36 @@ struct account_code {
 };
 FC_REFLECT(account_code, (id)(ref_count)(code)(code_hash));
 
+struct code_meta {
+   uint64_t    id;
+   uint32_t    ref_count;
+   bytes       code_hash;
+
+   static name table_name() { return "codemeta"_n; }
+   static name index_name(const name& n) {
+      uint64_t index_table_name = table_name().to_uint64_t() & 0xFFFFFFFFFFFFFFF0ULL;
+
+     return name{index_table_name | 0};
+   }
+
+   static name index_name(uint64_t n) {
+      return index_name(name{n});
+   }
+
+   static std::optional<code_meta> get_by_code_hash(chainbase::database& db, const evmc::bytes32& code_hash) {
+      return get_by_index<evmc::bytes32, code_meta>(db, "evm"_n, "by.codehash"_n, code_hash);
+   }
+};
+FC_REFLECT(code_meta, (id)(ref_count)(code_hash));
+
+struct code_blob {
+   uint64_t    id;
+   bytes       code;
+
+   static name table_name() { return "codeblob"_n; }
+};
+FC_REFLECT(code_blob, (id)(code));
+
 struct storage {
    uint64_t id;
    bytes    key;
@@ -371,6 +450,40 @@ struct storage {
 };
 FC_REFLECT(storage, (id)(key)(value));
 
+struct storage2 {
+   uint64_t id;
+   bytes    key;   // without leading zero bytes
+   bytes    value; // without leading zero bytes
+
+   // Same id as the one derived by the contract, collisions probe the following ids
+   static uint64_t slot_id(const evmc::bytes32& location) {
+      const auto hash = ethash::keccak256(location.bytes, sizeof(location.bytes));
+      return intx::be::unsafe::load<uint64_t>(hash.bytes);
+   }
+
+   static bytes compact(const evmc::bytes32& data) {
+      auto first = std::find_if(std::begin(data.bytes), std::end(data.bytes), [](uint8_t b) { return b != 0; });
+      return bytes{first, std::end(data.bytes)};
+   }
+
+   evmc::bytes32 get_value() const {
+      evmc::bytes32 res;
+      memcpy(res.bytes + sizeof(res.bytes) - value.size(), value.data(), value.size());
+      return res;
+   }
+
+   static name table_name() { return "storage2"_n; }
+
+   static std::optional<storage2> get(chainbase::database& db, uint64_t account, const evmc::bytes32& location) {
+      const auto key = compact(location);
+      for (uint64_t id = slot_id(location);; ++id) {
+         auto row = find_by_primary_key<uint64_t, storage2>(db, name{account}, id);
+         if (!row || row->key == key) return row;
+      }
+   }
+};
+FC_REFLECT(storage2, (id)(key)(value));
+
 struct gcstore {
    uint64_t id;
    uint64_t storage_id;
@@ -590,6 +703,13 @@ struct evm_runtime_tester : eosio_system_tester, silkworm::State {
       );
    }
 
+   action_result testrecover( const bytes& rlptx, const bytes& sender ) {
+      return call(ME, "testrecover"_n, mvo()
+         ("rlptx", rlptx)
+         ("sender", sender)
+      );
+   }
+
    //------ silkworm state impl
    std::optional<Account> read_account(const evmc::address& address) const noexcept {
       auto& db = const_cast<chainbase::database&>(control->db());
@@ -597,10 +717,15 @@ struct evm_runtime_tester : eosio_system_tester, silkworm::State {
       if(!accnt) return {};
 
       if (accnt->code_id.has_value()) {
-         auto r = get_by_primary_key<uint64_t, account_code>(db, "evm"_n, accnt->code_id.value());
-         if (r) {
+         std::optional<bytes> code_hash;
+         if (auto m = find_by_primary_key<uint64_t, code_meta>(db, "evm"_n, accnt->code_id.value())) {
+            code_hash = m->code_hash;
+         } else {
+            code_hash = get_by_primary_key<uint64_t, account_code>(db, "evm"_n, accnt->code_id.value())->code_hash;
+         }
+         if (code_hash) {
             evmc::bytes32 res;
-            std::copy(r.value().code_hash.begin(), r.value().code_hash.end(), res.bytes);
+            std::copy(code_hash->begin(), code_hash->end(), res.bytes);
             return Account{
                accnt->nonce,
                intx::be::load<u256>(accnt->get_balance()),
@@ -620,6 +745,10 @@ struct evm_runtime_tester : eosio_system_tester, silkworm::State {
    mutable bytes read_code_buffer;
    ByteView read_code(const evmc::bytes32& code_hash) const noexcept {
       auto& db = const_cast<chainbase::database&>(control->db());
+      if (auto meta = code_meta::get_by_code_hash(db, code_hash)) {
+         read_code_buffer = get_by_primary_key<uint64_t, code_blob>(db, "evm"_n, meta->id)->code;
+         return ByteView{(const uint8_t*)read_code_buffer.data(), read_code_buffer.size()};
+      }
       auto accntcode = account_code::get_by_code_hash(db, code_hash);
       if(!accntcode) {
          dlog("no code for hash ${ch}", ("ch",to_bytes(code_hash)));
@@ -635,6 +764,9 @@ struct evm_runtime_tester : eosio_system_tester, silkworm::State {
       auto& db = const_cast<chainbase::database&>(control->db());
       auto accnt = account::get_by_address(db, address);
       if(!accnt) return {};
+      if(auto s2 = storage2::get(db, accnt->id, location)) {
+         return s2->get_value();
+      }
       auto s = storage::get(db, accnt->id, location);
       if(!s) return {};
       return s->get_value();
@@ -727,20 +859,24 @@ struct evm_runtime_tester : eosio_system_tester, silkworm::State {
    size_t number_of_accounts() {
       auto& db = const_cast<chainbase::database&>(control->db());
 
-      const auto* tid = db.find<table_id_object, by_code_scope_table>(
-         boost::make_tuple("evm"_n, "evm"_n,"account"_n)
-      );
+      const auto count_rows = [&](name table) {
+         const auto* tid = db.find<table_id_object, by_code_scope_table>(
+            boost::make_tuple("evm"_n, "evm"_n, table)
+         );
 
-      if(tid == nullptr) return 0;
+         if(tid == nullptr) return size_t{0};
 
-      const auto& idx = db.get_index<key_value_index, by_scope_primary>();
-      auto itr = idx.lower_bound( boost::make_tuple( tid->id) );
-      size_t count=0;
-      while ( itr != idx.end() && itr->t_id == tid->id ) {
-         ++itr;
-         ++count;
-      }
-      return count;
+         const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+         auto itr = idx.lower_bound( boost::make_tuple( tid->id) );
+         size_t count=0;
+         while ( itr != idx.end() && itr->t_id == tid->id ) {
+            ++itr;
+            ++count;
+         }
+         return count;
+      };
+
+      return count_rows(account::table_name()) + count_rows(account2::table_name());
    }
 
    size_t state_storage_size(const evmc::address& address, uint64_t incarnation) {
@@ -751,41 +887,27 @@ struct evm_runtime_tester : eosio_system_tester, silkworm::State {
          return 0;
       }
 
-      //dlog("${a}", ("a",*accnt));
-      const auto* tid = db.find<table_id_object, by_code_scope_table>(
-         boost::make_tuple("evm"_n, name{accnt->id}, storage::table_name())
-      );
-
-      if(tid == nullptr) {
-         dlog("${a} => 0 (bis)",("a",to_bytes(address)));
-         return 0;
-      }
-
-      fc::mutable_variant_object mr;
-      mr("a",to_bytes(address));
-      //std::cout << "state_storage_size: " << fc::format_string("${a}",mr,true) << std::endl;
-
-      const auto& idx = db.get_index<key_value_index, by_scope_primary>();
-      auto itr = idx.lower_bound( boost::make_tuple(tid->id) );
-      size_t count=0;
-      while ( itr != idx.end() && itr->t_id == tid->id ) {
-
-         auto r = fc::raw::unpack<storage>(
-            itr->value.data(),
-            itr->value.size()
+      // Zero valued `storage2` rows only keep probe chains linked, they are not part of the state
+      const auto count_rows = [&](name table, auto is_slot) {
+         const auto* tid = db.find<table_id_object, by_code_scope_table>(
+            boost::make_tuple("evm"_n, name{accnt->id}, table)
          );
+         if(tid == nullptr) return size_t{0};
+
+         const auto& idx = db.get_index<key_value_index, by_scope_primary>();
+         auto itr = idx.lower_bound( boost::make_tuple(tid->id) );
+         size_t count=0;
+         while ( itr != idx.end() && itr->t_id == tid->id ) {
+            if (is_slot(itr->value)) ++count;
+            ++itr;
+         }
+         return count;
+      };
 
-         // fc::mutable_variant_object mu;
-         // mu( "a", r.key );
-         // mu( "b", r.value );
-         // std::cout << fc::format_string("   ${a}=${b}", mu, true) << std::endl;
-         
-         ++itr;
-         ++count;
-      }
-      //dlog("${a} => ${c}",("a",to_bytes(address))("c",count));
-      //std::cout << "   total: " << count << std::endl;
-      return count;
+      return count_rows(storage::table_name(), [](const auto&) { return true; }) +
+             count_rows(storage2::table_name(), [](const auto& value) {
+                return !fc::raw::unpack<storage2>(value.data(), value.size()).value.empty();
+             });
    }
 
    size_t gc_size() {
@@ -1166,4 +1288,91 @@ BOOST_AUTO_TEST_CASE( balance_and_dust_tests ) try {
    BOOST_REQUIRE_EQUAL(t.testbaldust("overflowd"_n),  t.error("assertion failure with message: accumulation overflow"));
 } FC_LOG_AND_RETHROW()
 
+BOOST_AUTO_TEST_CASE( recover_sender_tests ) try {
+   fc::temp_directory tmpdir;
+   evm_runtime_tester t(tmpdir);
+
+   // testrecover only exists in contracts built WITH_K1_RECOVER
+   if(t.evm_runtime_abi.get_action_type("testrecover"_n).empty()) return;
+
+   secp256k1_context* ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+   auto private_key = evmc::from_hex("a3f1b69da92a0233ce29485d3049a4ace39e8d384bbc2557e3fc60940ce4e954").value();
+
+   auto sign = [&](Transaction& trx) {
+      Bytes rlp;
+      trx.encode_for_signing(rlp);
+      ethash::hash256 hash{silkworm::keccak256(rlp)};
+
+      secp256k1_ecdsa_recoverable_signature sig;
+      BOOST_REQUIRE(secp256k1_ecdsa_sign_recoverable(ctx, &sig, hash.bytes, private_key.data(), NULL, NULL));
+      uint8_t r_and_s[64];
+      int recid;
+      secp256k1_ecdsa_recoverable_signature_serialize_compact(ctx, r_and_s, &recid, &sig);
+
+      trx.r = intx::be::unsafe::load<intx::uint256>(r_and_s);
+      trx.s = intx::be::unsafe::load<intx::uint256>(r_and_s + 32);
+      trx.odd_y_parity = recid;
+   };
+
+   // Expected sender is computed natively with silkworm
+   auto check_recover = [&](Transaction trx) {
+      Bytes rlp;
+      rlp::encode(rlp, trx);
+
+      trx.from.reset();
+      trx.recover_sender();
+      bytes sender;
+      if(trx.from) sender = to_bytes(*trx.from);
+
+      BOOST_REQUIRE_EQUAL(t.testrecover(to_bytes(rlp), sender), t.success());
+   };
+
+   Transaction legacy{
+      UnsignedTransaction {
+         .type = TransactionType::kLegacy,
+         .chain_id = 15555,
+         .nonce = 7,
+         .max_priority_fee_per_gas = 150'000'000'000,
+         .max_fee_per_gas = 150'000'000'000,
+         .gas_limit = 21000,
+         .to = evmc::address{0x1234},
+         .value = 1,
+      }
+   };
+   sign(legacy);
+   check_recover(legacy);
+
+   Transaction dynamic_fee{
+      UnsignedTransaction {
+         .type = TransactionType::kDynamicFee,
+         .chain_id = 15555,
+         .nonce = 8,
+         .max_priority_fee_per_gas = 1'000'000'000,
+         .max_fee_per_gas = 150'000'000'000,
+         .gas_limit = 100000,
+         .to = evmc::address{0x5678},
+         .value = 0,
+         .data = *from_hex("d09de08a"),
+      }
+   };
+   sign(dynamic_fee);
+   check_recover(dynamic_fee);
+
+   // A tampered signature still recovers (to a different address) on both backends
+   Transaction tampered = legacy;
+   tampered.s -= 1;
+   check_recover(tampered);
+
+   // Flipping the parity as well
+   tampered.odd_y_parity = !tampered.odd_y_parity;
+   check_recover(tampered);
+
+   // r out of range can't be recovered by either backend
+   Transaction invalid = legacy;
+   invalid.r = std::numeric_limits<intx::uint256>::max();
+   check_recover(invalid);
+
+   secp256k1_context_destroy(ctx);
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,233 @@
+#include "basic_evm_tester.hpp"
+#include <ethash/keccak.hpp>
+
+using namespace eosio::testing;
+using namespace evm_test;
+
+struct evmtx_evm_tester : basic_evm_tester
+{
+   evm_eoa faucet_eoa;
+
+   static constexpr name miner_account_name = "alice"_n;
+   static constexpr uint32_t compact_evmtx = 0x1;
+
+   evmtx_evm_tester() :
+      faucet_eoa(evmc::from_hex("a3f1b69da92a0233ce29485d3049a4ace39e8d384bbc2557e3fc60940ce4e954").value())
+   {
+      create_accounts({miner_account_name});
+      transfer_token(faucet_account_name, miner_account_name, make_asset(100'0000));
+      init();
+      open(miner_account_name);
+      transfer_token(faucet_account_name, evm_account_name, make_asset(100'0000), faucet_eoa.address_0x());
+      setversion(1, evm_account_name);
+      produce_blocks(2);
+   }
+
+   std::vector<silkworm::Transaction> generate_transfers(const std::vector<evmc::address>& recipients, const intx::uint256& value)
+   {
+      std::vector<silkworm::Transaction> txs;
+      for (const auto& recipient : recipients) {
+         auto tx = generate_tx(recipient, value);
+         faucet_eoa.sign(tx);
+         txs.push_back(std::move(tx));
+      }
+      return txs;
+   }
+
+   static const action_trace& find_evmtx(const transaction_trace_ptr& trace)
+   {
+      for (const auto& at : trace->action_traces) {
+         if (at.act.account == evm_account_name && at.act.name == "evmtx"_n) {
+            return at;
+         }
+      }
+      BOOST_FAIL("no evmtx event");
+      return trace->action_traces.front();
+   }
+
+   static silkworm::Transaction decode_rlptx(const bytes& rlptx)
+   {
+      silkworm::Transaction tx;
+      silkworm::ByteView bv{(const uint8_t*)rlptx.data(), rlptx.size()};
+      BOOST_REQUIRE(silkworm::rlp::decode(bv, tx));
+      BOOST_REQUIRE(bv.empty());
+      return tx;
+   }
+
+   // What an EVM node does with the evmtx events of an action, for every version of them
+   static std::vector<silkworm::Transaction> decode_evmtx(const transaction_trace_ptr& trace)
+   {
+      std::vector<bytes> rlptxs;
+      for (const auto& at : trace->action_traces) {
+         if (at.act.account != evm_account_name || at.act.name != "evmtx"_n) {
+            continue;
+         }
+         auto event = fc::raw::unpack<evmtx_type>(at.act.data.data(), at.act.data.size());
+         if (auto v0 = std::get_if<evmtx_v0>(&event)) {
+            rlptxs.push_back(v0->rlptx);
+            continue;
+         }
+
+         const auto& v1 = std::get<evmtx_v1>(event);
+         std::vector<bytes> event_rlptxs = v1.rlptxs;
+         if (event_rlptxs.empty()) {
+            // The rlp is in the action that sent the event
+            const auto& creator = trace->action_traces.at(at.creator_action_ordinal - 1);
+            fc::datastream<const char*> ds(creator.act.data.data(), creator.act.data.size());
+            name miner;
+            fc::raw::unpack(ds, miner);
+            if (creator.act.name == "pushtx"_n) {
+               event_rlptxs.emplace_back();
+               fc::raw::unpack(ds, event_rlptxs.back());
+            } else {
+               BOOST_REQUIRE(creator.act.name == "pushtxs"_n);
+               fc::raw::unpack(ds, event_rlptxs);
+            }
+
+            // The hashes tell which rlp of the action are the ones of the event
+            BOOST_REQUIRE_EQUAL(v1.rlp_hashes.size(), event_rlptxs.size());
+            for (size_t i = 0; i < event_rlptxs.size(); ++i) {
+               const auto hash = ethash::keccak256(reinterpret_cast<const uint8_t*>(event_rlptxs[i].data()), event_rlptxs[i].size());
+               BOOST_REQUIRE(v1.rlp_hashes[i] == bytes(hash.bytes, hash.bytes + sizeof(hash.bytes)));
+            }
+         } else {
+            BOOST_CHECK(v1.rlp_hashes.empty());
+         }
+         BOOST_REQUIRE_EQUAL(event_rlptxs.size(), v1.tx_count);
+         rlptxs.insert(rlptxs.end(), event_rlptxs.begin(), event_rlptxs.end());
+      }
+      BOOST_REQUIRE(!rlptxs.empty());
+
+      std::vector<silkworm::Transaction> txs;
+      for (const auto& rlptx : rlptxs) {
+         txs.push_back(decode_rlptx(rlptx));
+      }
+      return txs;
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(evmtx_evm_tests)
+
+BOOST_FIXTURE_TEST_CASE(setevents_requires_contract_auth, evmtx_evm_tester)
+try {
+   BOOST_CHECK(!get_config().event_flags.has_value());
+
+   BOOST_REQUIRE_EXCEPTION(setevents(compact_evmtx, miner_account_name),
+      missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+   setevents(compact_evmtx);
+   auto cfg = get_config();
+   BOOST_REQUIRE(cfg.event_flags.has_value());
+   BOOST_CHECK_EQUAL(*cfg.event_flags, compact_evmtx);
+   BOOST_CHECK(cfg.next_price_block.has_value());
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(pushed_transactions_are_not_repeated, evmtx_evm_tester)
+try {
+   evm_eoa recipient;
+
+   // Default events still decode as v0
+   auto tx = generate_transfers({recipient.address}, 1_gwei).front();
+   auto trace = pushtx(tx, miner_account_name);
+   const auto v0_size = find_evmtx(trace).act.data.size();
+   BOOST_REQUIRE(std::holds_alternative<evmtx_v0>(fc::raw::unpack<evmtx_type>(find_evmtx(trace).act.data)));
+   auto decoded = decode_evmtx(trace);
+   BOOST_REQUIRE_EQUAL(decoded.size(), 1);
+   BOOST_CHECK(decoded[0] == tx);
+
+   setevents(compact_evmtx);
+
+   tx = generate_transfers({recipient.address}, 1_gwei).front();
+   trace = pushtx(tx, miner_account_name);
+   auto event = fc::raw::unpack<evmtx_type>(find_evmtx(trace).act.data);
+   BOOST_REQUIRE(std::holds_alternative<evmtx_v1>(event));
+   const auto& v1 = std::get<evmtx_v1>(event);
+   BOOST_CHECK_EQUAL(v1.eos_evm_version, 1);
+   BOOST_CHECK_EQUAL(v1.base_fee_per_gas, get_config().gas_price);
+   BOOST_CHECK_EQUAL(v1.tx_count, 1);
+   BOOST_CHECK(v1.rlptxs.empty());
+   BOOST_CHECK_LT(find_evmtx(trace).act.data.size(), v0_size);
+
+   decoded = decode_evmtx(trace);
+   BOOST_REQUIRE_EQUAL(decoded.size(), 1);
+   BOOST_CHECK(decoded[0] == tx);
+
+   auto txs = generate_transfers({recipient.address, recipient.address}, 1_gwei);
+   trace = pushtxs(txs, miner_account_name);
+   decoded = decode_evmtx(trace);
+   BOOST_REQUIRE_EQUAL(decoded.size(), txs.size());
+   for (size_t i = 0; i < txs.size(); ++i) {
+      BOOST_CHECK(decoded[i] == txs[i]);
+   }
+
+   BOOST_CHECK_EQUAL(*evm_balance(recipient), 4_gwei);
+   check_balances();
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(synthesized_transactions_keep_their_rlp, evmtx_evm_tester)
+try {
+   evm_eoa recipient;
+   setevents(compact_evmtx);
+
+   // A deposit is built by the contract, there is no rlp in the transfer action to refer to
+   auto trace = transfer_token(faucet_account_name, evm_account_name, make_asset(1'0000), recipient.address_0x());
+   auto event = fc::raw::unpack<evmtx_type>(find_evmtx(trace).act.data);
+   BOOST_REQUIRE(std::holds_alternative<evmtx_v1>(event));
+   const auto& v1 = std::get<evmtx_v1>(event);
+   BOOST_CHECK_EQUAL(v1.tx_count, 1);
+   BOOST_REQUIRE_EQUAL(v1.rlptxs.size(), 1);
+
+   auto decoded = decode_evmtx(trace);
+   BOOST_REQUIRE_EQUAL(decoded.size(), 1);
+   BOOST_CHECK(decoded[0].to == recipient.address);
+   BOOST_CHECK(decoded[0].value == intx::uint256(balance_and_dust{make_asset(1'0000), 0}));
+
+   // Turning the flag off goes back to v0
+   setevents(0);
+   trace = transfer_token(faucet_account_name, evm_account_name, make_asset(1'0000), recipient.address_0x());
+   BOOST_REQUIRE(std::holds_alternative<evmtx_v0>(fc::raw::unpack<evmtx_type>(find_evmtx(trace).act.data)));
+   decoded = decode_evmtx(trace);
+   BOOST_REQUIRE_EQUAL(decoded.size(), 1);
+   BOOST_CHECK(decoded[0].to == recipient.address);
+
+   check_balances();
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(mixed_batches_keep_all_their_rlp, evmtx_evm_tester)
+try {
+   evm_eoa recipient;
+   setevents(compact_evmtx);
+
+   // Only the first transaction is in the action data, the event can't refer to the others
+   auto txs = generate_transfers({recipient.address, recipient.address}, 1_gwei);
+   std::vector<bytes> rlptxs;
+   for (const auto& tx : txs) {
+      silkworm::Bytes rlp;
+      silkworm::rlp::encode(rlp, tx);
+      rlptxs.emplace_back(rlp.begin(), rlp.end());
+   }
+   auto trace = push_action(evm_account_name, "testmixedtx"_n, evm_account_name,
+      mvo()("miner", miner_account_name)("rlptxs", rlptxs));
+
+   auto event = fc::raw::unpack<evmtx_type>(find_evmtx(trace).act.data);
+   BOOST_REQUIRE(std::holds_alternative<evmtx_v1>(event));
+   const auto& v1 = std::get<evmtx_v1>(event);
+   BOOST_CHECK_EQUAL(v1.tx_count, 2);
+   BOOST_CHECK_EQUAL(v1.rlptxs.size(), 2);
+   BOOST_CHECK(v1.rlp_hashes.empty());
+
+   auto decoded = decode_evmtx(trace);
+   BOOST_REQUIRE_EQUAL(decoded.size(), txs.size());
+   for (size_t i = 0; i < txs.size(); ++i) {
+      BOOST_CHECK(decoded[i] == txs[i]);
+   }
+
+   BOOST_CHECK_EQUAL(*evm_balance(recipient), 2_gwei);
+   check_balances();
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,31 @@ struct gas_fee_evm_tester : basic_evm_tester
    {
       transfer_token(faucet_account_name, evm_account_name, make_asset(100'0000), faucet_eoa.address_0x());
    }
+
+   transaction_trace_ptr setgcbudget(uint32_t max, uint32_t max_inline_slots)
+   {
+      return push_action(evm_account_name, "setgcbudget"_n, evm_account_name,
+         mvo()("max", max)("max_inline_slots", max_inline_slots));
+   }
+
+   // Cuts the config row back to the layout written before next_price_block and event_flags
+   void drop_next_price_block()
+   {
+      auto& db = const_cast<chainbase::database&>(control->db());
+      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+         boost::make_tuple(evm_account_name, evm_account_name, "config"_n));
+      BOOST_REQUIRE(t_id);
+      const auto* row = db.find<chain::key_value_object, chain::by_scope_primary>(
+         boost::make_tuple(t_id->id, "config"_n.to_uint64_t()));
+      BOOST_REQUIRE(row);
+      const auto cut = sizeof(uint64_t) + sizeof(uint32_t);
+      BOOST_REQUIRE(row->value.size() > cut);
+      const std::string value(row->value.data(), row->value.size() - cut);
+      db.modify(*row, [&](auto& kv) {
+         kv.value.assign(value.data(), value.size());
+      });
+      BOOST_REQUIRE(!get_config().next_price_block.has_value());
+   }
 };
 
 BOOST_AUTO_TEST_SUITE(gas_fee_evm_tests)
@@ -366,6 +391,12 @@ try {
    BOOST_CHECK_EQUAL(q[1].block, b2);
    BOOST_CHECK_EQUAL(q[1].price, 2*ten_gwei);
 
+   // Nothing is due yet, processing caches the front of the queue
+   trigger_price_queue_processing();
+   cfg = get_config();
+   BOOST_REQUIRE(cfg.next_price_block.has_value());
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, b1);
+
    while(bm.timestamp_to_evm_block_num(control->pending_block_time().time_since_epoch().count()) != b1) {
       produce_blocks(1);
    }
@@ -373,6 +404,8 @@ try {
 
    cfg = get_config();
    BOOST_CHECK_EQUAL(cfg.gas_price, ten_gwei);
+   BOOST_REQUIRE(cfg.next_price_block.has_value());
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, b2);
 
    q = get_price_queue();
    BOOST_CHECK_EQUAL(q.size(), 1);
@@ -386,9 +419,62 @@ try {
 
    cfg = get_config();
    BOOST_CHECK_EQUAL(cfg.gas_price, 2*ten_gwei);
+   BOOST_REQUIRE(cfg.next_price_block.has_value());
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, 0);
 
    q = get_price_queue();
    BOOST_CHECK_EQUAL(q.size(), 0);
+
+   // Queueing into an empty queue updates the cached block
+   setfeeparams({.gas_price = ten_gwei});
+   auto t3 = (control->pending_block_time()+fc::seconds(price_queue_grace_period)).time_since_epoch().count();
+   auto b3 = bm.timestamp_to_evm_block_num(t3)+1;
+
+   cfg = get_config();
+   BOOST_REQUIRE(cfg.next_price_block.has_value());
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, b3);
+
+   while(bm.timestamp_to_evm_block_num(control->pending_block_time().time_since_epoch().count()) != b3) {
+      produce_blocks(1);
+   }
+   trigger_price_queue_processing();
+
+   cfg = get_config();
+   BOOST_CHECK_EQUAL(cfg.gas_price, ten_gwei);
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, 0);
+   BOOST_CHECK_EQUAL(get_price_queue().size(), 0);
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(queued_price_survives_config_upgrade, gas_fee_evm_tester)
+try {
+   init();
+   eosevm::block_mapping bm(get_config().genesis_time.sec_since_epoch());
+   setversion(1, evm_account_name);
+   produce_blocks(2);
+
+   const auto ten_gwei = 10'000'000'000ull;
+
+   // A price queued by a contract that did not know about next_price_block
+   setfeeparams({.gas_price = ten_gwei});
+   auto t1 = (control->pending_block_time()+fc::seconds(price_queue_grace_period)).time_since_epoch().count();
+   auto b1 = bm.timestamp_to_evm_block_num(t1)+1;
+   drop_next_price_block();
+
+   // The first write of the config must not record an empty queue
+   setgcbudget(2, 0);
+   auto cfg = get_config();
+   BOOST_REQUIRE(cfg.next_price_block.has_value());
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, b1);
+
+   while(bm.timestamp_to_evm_block_num(control->pending_block_time().time_since_epoch().count()) != b1) {
+      produce_blocks(1);
+   }
+   transfer_token("alice"_n, evm_account_name, make_asset(1), evm_account_name.to_string());
+
+   cfg = get_config();
+   BOOST_CHECK_EQUAL(cfg.gas_price, ten_gwei);
+   BOOST_CHECK_EQUAL(*cfg.next_price_block, 0);
 }
 FC_LOG_AND_RETHROW()
 
@@ -0,0 +1,266 @@
+#include "basic_evm_tester.hpp"
+
+using namespace evm_test;
+
+struct gc_result {
+   uint32_t rows_deleted;
+   uint32_t entries_completed;
+   uint64_t backlog;
+};
+FC_REFLECT(gc_result, (rows_deleted)(entries_completed)(backlog))
+
+struct gc_backlog_entry {
+   uint64_t id;
+   uint64_t storage_id;
+   uint32_t rows;
+};
+FC_REFLECT(gc_backlog_entry, (id)(storage_id)(rows))
+
+struct gc_backlog {
+   uint64_t                      entries;
+   std::vector<gc_backlog_entry> next;
+};
+FC_REFLECT(gc_backlog, (entries)(next))
+
+struct storage_usage {
+   uint32_t slots;
+   uint32_t bytes;
+};
+FC_REFLECT(storage_usage, (slots)(bytes))
+
+struct gc_tester : basic_evm_tester {
+   gc_tester() {
+      create_accounts({"alice"_n});
+      transfer_token(faucet_account_name, "alice"_n, make_asset(10000'0000));
+      init();
+   }
+
+   uint64_t fill_storage(const evm_eoa& eoa, uint32_t slots) {
+      transfer_token("alice"_n, evm_account_name, make_asset(10000), eoa.address_0x());
+      const auto id = find_account_by_address(eoa.address)->id;
+      for (uint32_t i = 1; i <= slots; ++i) {
+         setkvstore(id, to_bytes(intx::uint256(i)), to_bytes(intx::uint256(i)));
+      }
+      return id;
+   }
+
+   // Queues the storage of a new account holding `slots` slots for collection
+   uint64_t queue_storage(uint32_t slots) {
+      evm_eoa eoa;
+      const auto id = fill_storage(eoa, slots);
+      rmaccount(id);
+      return id;
+   }
+
+   gc_result collect(uint32_t max) {
+      auto trace = gc(max);
+      return fc::raw::unpack<gc_result>(trace->action_traces[0].return_value);
+   }
+
+   transaction_trace_ptr setgcbudget(uint32_t max, uint32_t max_inline_slots, name actor=evm_account_name) {
+      return push_action(evm_account_name, "setgcbudget"_n, actor,
+         mvo()("max", max)("max_inline_slots", max_inline_slots));
+   }
+
+   std::optional<storage_usage> storageusage(const evmc::address& address) {
+      auto trace = push_action(evm_account_name, "storageusage"_n, evm_account_name, mvo()("address", to_bytes(address)));
+      return fc::raw::unpack<std::optional<storage_usage>>(trace->action_traces[0].return_value);
+   }
+
+   bool countgc(uint32_t max) {
+      auto trace = push_action(evm_account_name, "countgc"_n, evm_account_name, mvo()("max", max));
+      return fc::raw::unpack<bool>(trace->action_traces[0].return_value);
+   }
+
+   // Drops `gcprogress` the way a contract that predates it leaves the backlog
+   void drop_gc_progress() {
+      auto& db = const_cast<chainbase::database&>(control->db());
+      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+         boost::make_tuple(evm_account_name, evm_account_name, "gcprogress"_n));
+      BOOST_REQUIRE(t_id);
+      const auto* row = db.find<chain::key_value_object, chain::by_scope_primary>(
+         boost::make_tuple(t_id->id, "gcprogress"_n.to_uint64_t()));
+      BOOST_REQUIRE(row);
+      db.remove(*row);
+      db.modify(*t_id, [](auto& t) { --t.count; });
+   }
+
+   gc_backlog backlog(uint32_t max_entries, uint32_t max_rows) {
+      auto trace = gcbacklog(max_entries, max_rows);
+      return fc::raw::unpack<gc_backlog>(trace->action_traces[0].return_value);
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(gc_tests)
+
+BOOST_FIXTURE_TEST_CASE(gc_resumes_after_the_entry_it_stopped_in, gc_tester) try {
+
+   const auto big = queue_storage(5);
+   const auto small1 = queue_storage(1);
+   const auto small2 = queue_storage(1);
+
+   auto pending = backlog(10, 100);
+   BOOST_CHECK_EQUAL(pending.entries, 3);
+   BOOST_REQUIRE_EQUAL(pending.next.size(), 3);
+   BOOST_CHECK_EQUAL(pending.next[0].storage_id, big);
+   BOOST_CHECK_EQUAL(pending.next[0].rows, 5);
+   BOOST_CHECK_EQUAL(pending.next[1].storage_id, small1);
+   BOOST_CHECK_EQUAL(pending.next[1].rows, 1);
+   BOOST_CHECK_EQUAL(pending.next[2].storage_id, small2);
+   BOOST_CHECK_EQUAL(backlog(10, 2).next[0].rows, 2);
+
+   auto res = collect(3);
+   BOOST_CHECK_EQUAL(res.rows_deleted, 3);
+   BOOST_CHECK_EQUAL(res.entries_completed, 0);
+   BOOST_CHECK_EQUAL(res.backlog, 3);
+
+   // The next call starts with the entries queued after the large one
+   pending = backlog(1, 100);
+   BOOST_REQUIRE_EQUAL(pending.next.size(), 1);
+   BOOST_CHECK_EQUAL(pending.next[0].storage_id, small1);
+
+   res = collect(4);
+   BOOST_CHECK_EQUAL(res.rows_deleted, 2);
+   BOOST_CHECK_EQUAL(res.entries_completed, 2);
+   BOOST_CHECK_EQUAL(res.backlog, 1);
+
+   pending = backlog(10, 100);
+   BOOST_REQUIRE_EQUAL(pending.next.size(), 1);
+   BOOST_CHECK_EQUAL(pending.next[0].storage_id, big);
+   BOOST_CHECK_EQUAL(pending.next[0].rows, 2);
+
+   res = collect(10);
+   BOOST_CHECK_EQUAL(res.rows_deleted, 2);
+   BOOST_CHECK_EQUAL(res.entries_completed, 1);
+   BOOST_CHECK_EQUAL(res.backlog, 0);
+   BOOST_CHECK(backlog(10, 100).next.empty());
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(removed_entries_leave_the_backlog, gc_tester) try {
+
+   queue_storage(1);
+   queue_storage(1);
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 2);
+
+   rmgcstore(0);
+   auto pending = backlog(10, 100);
+   BOOST_CHECK_EQUAL(pending.entries, 1);
+   BOOST_REQUIRE_EQUAL(pending.next.size(), 1);
+   BOOST_CHECK_EQUAL(pending.next[0].id, 1);
+
+   BOOST_CHECK_EQUAL(collect(10).backlog, 0);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(transactions_spend_the_gc_budget, gc_tester) try {
+
+   queue_storage(3);
+   queue_storage(1);
+
+   BOOST_REQUIRE_EXCEPTION(setgcbudget(2, 0, "alice"_n),
+      missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+   // Without a budget transactions leave the backlog alone
+   evm_eoa evm1;
+   transfer_token("alice"_n, evm_account_name, make_asset(10000), evm1.address_0x());
+   BOOST_CHECK_EQUAL(backlog(10, 100).next[0].rows, 3);
+
+   setgcbudget(2, 0);
+   transfer_token("alice"_n, evm_account_name, make_asset(10000), evm1.address_0x());
+   auto pending = backlog(10, 100);
+   BOOST_CHECK_EQUAL(pending.entries, 2);
+   BOOST_REQUIRE_EQUAL(pending.next.size(), 2);
+   BOOST_CHECK_EQUAL(pending.next[0].id, 1);
+   BOOST_CHECK_EQUAL(pending.next[1].rows, 1);
+
+   transfer_token("alice"_n, evm_account_name, make_asset(10000), evm1.address_0x());
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 1);
+   transfer_token("alice"_n, evm_account_name, make_asset(10000), evm1.address_0x());
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 0);
+
+   // Nothing left to collect
+   transfer_token("alice"_n, evm_account_name, make_asset(10000), evm1.address_0x());
+   check_balances();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(small_storage_is_erased_inline, gc_tester) try {
+
+   evm_eoa small;
+   evm_eoa big;
+   const auto small_id = fill_storage(small, 2);
+   const auto big_id = fill_storage(big, 3);
+
+   auto usage = storageusage(big.address);
+   BOOST_REQUIRE(usage);
+   BOOST_CHECK_EQUAL(usage->slots, 3);
+   // id, and one byte long key and value with their length prefixes
+   BOOST_CHECK_EQUAL(usage->bytes, 3 * (8 + 2 + 2));
+   setkvstore(big_id, to_bytes(intx::uint256(3)), {});
+   BOOST_CHECK_EQUAL(storageusage(big.address)->slots, 2);
+   setkvstore(big_id, to_bytes(intx::uint256(3)), to_bytes(intx::uint256(3)));
+   BOOST_CHECK(!storageusage(evm_eoa{}.address));
+
+   setgcbudget(0, 2);
+   rmaccount(small_id);
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 0);
+   size_t rows = 0;
+   scan_account_storage(small_id, [&](storage_slot&&) {
+      ++rows;
+      return false;
+   });
+   BOOST_CHECK_EQUAL(rows, 0);
+
+   rmaccount(big_id);
+   auto pending = backlog(10, 100);
+   BOOST_CHECK_EQUAL(pending.entries, 1);
+   BOOST_REQUIRE_EQUAL(pending.next.size(), 1);
+   BOOST_CHECK_EQUAL(pending.next[0].storage_id, big_id);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(backlog_of_older_contract_is_counted_apart, gc_tester) try {
+
+   queue_storage(1);
+   queue_storage(1);
+   queue_storage(1);
+   drop_gc_progress();
+
+   // Transactions queue new entries without counting the old backlog
+   queue_storage(1);
+   auto pending = backlog(10, 100);
+   BOOST_CHECK_EQUAL(pending.entries, 0);
+   BOOST_CHECK_EQUAL(pending.next.size(), 4);
+
+   BOOST_REQUIRE_EXCEPTION(push_action(evm_account_name, "countgc"_n, "alice"_n, mvo()("max", 10)),
+      missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+   BOOST_CHECK(!countgc(2));
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 2);
+   BOOST_CHECK(countgc(10));
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 4);
+   BOOST_CHECK(countgc(10));
+
+   auto res = collect(100);
+   BOOST_CHECK_EQUAL(res.entries_completed, 4);
+   BOOST_CHECK_EQUAL(res.backlog, 0);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(gc_counts_down_a_backlog_still_being_counted, gc_tester) try {
+
+   queue_storage(1);
+   queue_storage(1);
+   drop_gc_progress();
+
+   // Collected entries that were not counted yet leave the count alone
+   auto res = collect(100);
+   BOOST_CHECK_EQUAL(res.entries_completed, 2);
+   BOOST_CHECK_EQUAL(res.backlog, 0);
+   BOOST_CHECK(countgc(10));
+   BOOST_CHECK_EQUAL(backlog(10, 100).entries, 0);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+#include "basic_evm_tester.hpp"
+
+using namespace eosio::testing;
+using namespace evm_test;
+
+struct keccak_evm_tester : faucet_evm_tester
+{
+   /*
+      Hand assembled; increments mapping(uint256 => uint256) at slot 0 for keys [0, n)
+      where n is the first calldata word:
+
+         PUSH1 0
+      loop:
+         JUMPDEST
+         DUP1 PUSH1 0 CALLDATALOAD GT ISZERO PUSH1 end JUMPI
+         DUP1 PUSH1 0 MSTORE                  ; mem[0..32)  = i, mem[32..64) = 0
+         PUSH1 0x40 PUSH1 0 SHA3              ; slot = keccak256(i . 0)
+         DUP1 SLOAD PUSH1 1 ADD SWAP1 SSTORE  ; map[i] += 1
+         PUSH1 1 ADD PUSH1 loop JUMP
+      end:
+         JUMPDEST STOP
+   */
+   static constexpr const char* mapping_contract_bytecode_hex =
+      "6024600c60003960246000f3"
+      "60005b80600035111560225780600052604060002080546001019055600101600256"
+      "5b00";
+
+   transaction_trace_ptr touch_mapping(const evmc::address& contract_addr, uint64_t n)
+   {
+      auto txn = generate_tx(contract_addr, 0, 2'000'000);
+      txn.data = silkworm::Bytes{evmc::bytes32{n}};
+      faucet_eoa.sign(txn);
+      return pushtx(txn);
+   }
+
+   static intx::uint256 mapping_slot(uint64_t key)
+   {
+      uint8_t buffer[64] = {};
+      intx::be::unsafe::store(buffer, intx::uint256{key});
+      return intx::be::load<intx::uint256>(ethash::keccak256(buffer, sizeof(buffer)));
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(keccak_evm_tests)
+
+BOOST_FIXTURE_TEST_CASE(sha3_opcode_matches_native_keccak, keccak_evm_tester)
+try {
+   auto contract_addr = deploy_contract(faucet_eoa, evmc::from_hex(mapping_contract_bytecode_hex).value());
+
+   // CREATE address derivation and code hashing must agree with the native implementation
+   auto contract_account = find_account_by_address(contract_addr);
+   BOOST_REQUIRE(contract_account.has_value());
+   BOOST_REQUIRE(contract_account->code_id.has_value());
+
+   const auto runtime_code = evmc::from_hex(std::string{mapping_contract_bytecode_hex}.substr(24)).value();
+   const auto expected_code_hash = ethash::keccak256(runtime_code.data(), runtime_code.size());
+   bool code_found = false;
+   scan_account_code([&](account_code code) -> bool {
+      if (code.id == *contract_account->code_id) {
+         BOOST_REQUIRE_EQUAL(code.code_hash.size(), sizeof(expected_code_hash.bytes));
+         BOOST_CHECK(std::memcmp(code.code_hash.data(), expected_code_hash.bytes, sizeof(expected_code_hash.bytes)) == 0);
+         code_found = true;
+         return true;
+      }
+      return false;
+   });
+   BOOST_REQUIRE(code_found);
+
+   constexpr uint64_t keys = 8;
+   touch_mapping(contract_addr, keys);
+   touch_mapping(contract_addr, keys / 2);
+
+   std::map<intx::uint256, intx::uint256> storage;
+   scan_account_storage(contract_account->id, [&](storage_slot slot) -> bool {
+      storage[slot.key] = slot.value;
+      return false;
+   });
+
+   BOOST_REQUIRE_EQUAL(storage.size(), keys);
+   for (uint64_t i = 0; i < keys; ++i) {
+      auto itr = storage.find(mapping_slot(i));
+      BOOST_REQUIRE(itr != storage.end());
+      BOOST_CHECK_EQUAL(itr->second, i < keys / 2 ? 2 : 1);
+   }
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
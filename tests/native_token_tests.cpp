@@ -204,6 +204,26 @@ BOOST_FIXTURE_TEST_CASE(transfer_notifier_without_init, native_token_evm_tester_
 
 } FC_LOG_AND_RETHROW()
 
+BOOST_FIXTURE_TEST_CASE(outgoing_transfers_skip_config, native_token_evm_tester_EOS) try {
+   open("alice"_n);
+   transfer_token("alice"_n, "evm"_n, make_asset(1'0000), "alice");
+
+   // Leave a `config` row that can't be unpacked, any read of it fails the transaction
+   auto& db = const_cast<chainbase::database&>(control->db());
+   const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+      boost::make_tuple("evm"_n, "evm"_n, "config"_n));
+   BOOST_REQUIRE(t_id);
+   const auto* row = db.find<chain::key_value_object, chain::by_scope_primary>(
+      boost::make_tuple(t_id->id, "config"_n.to_uint64_t()));
+   BOOST_REQUIRE(row);
+   db.modify(*row, [](auto& r) { r.value.assign(nullptr, 0); });
+
+   // The notification of a transfer that is not a deposit returns before loading the config
+   transfer_token("evm"_n, "alice"_n, make_asset(1), "");
+   BOOST_REQUIRE_THROW(transfer_token("alice"_n, "evm"_n, make_asset(1), "alice"), fc::exception);
+
+} FC_LOG_AND_RETHROW()
+
 BOOST_FIXTURE_TEST_CASE(basic_eos_evm_bridge, native_token_evm_tester_EOS) try {
    evm_eoa evm1, evm2;
 
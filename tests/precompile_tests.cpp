@@ -0,0 +1,180 @@
+#include "basic_evm_tester.hpp"
+
+using namespace eosio::testing;
+using namespace evm_test;
+
+struct precompile_evm_tester : basic_evm_tester
+{
+   // alt_bn128 generators; G2 coordinates are in EIP-197 order (x_im, x_re, y_im, y_re)
+   static constexpr const char* g1_hex =
+      "0000000000000000000000000000000000000000000000000000000000000001"
+      "0000000000000000000000000000000000000000000000000000000000000002";
+   static constexpr const char* neg_g1_hex =
+      "0000000000000000000000000000000000000000000000000000000000000001"
+      "30644e72e131a029b85045b68181585d97816a916871ca8d3c208c16d87cfd45";
+   static constexpr const char* g2_hex =
+      "198e9393920d483a7260bfb731fb5d25f1aa493335a9e71297e485b7aef312c2"
+      "1800deef121f1e76426a00665e5c4479674322d4f75edadd46debd5cd992f6ed"
+      "090689d0585ff075ec9e99ad690c3395bc4b313370b38ef355acdadcd122975b"
+      "12c85ea5db8c6deb4aab71808dcb408fe3d1e7690c43d37b4ce6cc0166fa7daa";
+
+   precompile_evm_tester()
+   {
+      init();
+   }
+
+   static silkworm::Bytes from_hex(const std::string& hex)
+   {
+      return evmc::from_hex(hex).value();
+   }
+
+   exec_output call_precompile(uint8_t precompile, const silkworm::Bytes& input)
+   {
+      evmc::address addr{};
+      addr.bytes[sizeof(addr.bytes) - 1] = precompile;
+
+      exec_input in;
+      in.to = bytes{std::begin(addr.bytes), std::end(addr.bytes)};
+      in.data = bytes{input.begin(), input.end()};
+
+      auto trace = exec(in, {});
+      BOOST_REQUIRE(trace);
+      BOOST_REQUIRE(trace->action_traces.size() == 1);
+      return fc::raw::unpack<exec_output>(trace->action_traces[0].return_value);
+   }
+
+   silkworm::Bytes run_precompile(uint8_t precompile, const silkworm::Bytes& input)
+   {
+      auto out = call_precompile(precompile, input);
+      BOOST_REQUIRE_EQUAL(out.status, 0);
+      return silkworm::Bytes{out.data.begin(), out.data.end()};
+   }
+
+   bool precompile_fails(uint8_t precompile, const silkworm::Bytes& input)
+   {
+      return call_precompile(precompile, input).status != 0;
+   }
+
+};
+
+BOOST_AUTO_TEST_SUITE(precompile_evm_tests)
+
+BOOST_FIXTURE_TEST_CASE(sha256_and_ripemd160, precompile_evm_tester)
+try {
+   BOOST_CHECK(run_precompile(0x02, {}) == from_hex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+   BOOST_CHECK(run_precompile(0x02, from_hex("616263")) == from_hex("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+
+   // ripemd160 output is left padded to 32 bytes
+   BOOST_CHECK(run_precompile(0x03, {}) == from_hex("0000000000000000000000009c1185a5c5e9fc54612808977ee8f548b2258d31"));
+   BOOST_CHECK(run_precompile(0x03, from_hex("616263")) == from_hex("0000000000000000000000008eb208f7e05d987a9b044a8e98c6b087f15a0bfc"));
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(modexp, precompile_evm_tester)
+try {
+   auto modexp_input = [](const silkworm::Bytes& base, const silkworm::Bytes& exp, const silkworm::Bytes& mod) {
+      silkworm::Bytes input;
+      input += evmc::bytes32{base.size()};
+      input += evmc::bytes32{exp.size()};
+      input += evmc::bytes32{mod.size()};
+      input += base;
+      input += exp;
+      input += mod;
+      return input;
+   };
+
+   // 3^5 mod 7 == 5
+   BOOST_CHECK(run_precompile(0x05, modexp_input(from_hex("03"), from_hex("05"), from_hex("07"))) == from_hex("05"));
+
+   // Output has the length of the modulus
+   BOOST_CHECK(run_precompile(0x05, modexp_input(from_hex("03"), from_hex("05"), from_hex("0007"))) == from_hex("0005"));
+
+   // Missing trailing bytes are zero, here the modulus
+   auto truncated = modexp_input(from_hex("03"), from_hex("05"), from_hex("07"));
+   truncated.pop_back();
+   BOOST_CHECK(run_precompile(0x05, truncated) == from_hex("00"));
+
+   // Zero modulus
+   BOOST_CHECK(run_precompile(0x05, modexp_input(from_hex("03"), from_hex("05"), from_hex("0000"))) == from_hex("0000"));
+   BOOST_CHECK(run_precompile(0x05, modexp_input(from_hex("03"), from_hex("05"), {})).empty());
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(blake2f, precompile_evm_tester)
+try {
+   // EIP-152 test vector 5: blake2b("abc") compression with 12 rounds
+   silkworm::Bytes input = from_hex("0000000c");
+   input += from_hex("48c9bdf267e6096a3ba7ca8485ae67bb2bf894fe72f36e3cf1361d5f3af54fa5"
+                     "d182e6ad7f520e511f6c3e2b8c68059b6bbd41fbabd9831f79217e1319cde05b");
+   silkworm::Bytes m(128, 0);
+   m[0] = 'a'; m[1] = 'b'; m[2] = 'c';
+   input += m;
+   input += from_hex("0300000000000000");
+   input += from_hex("0000000000000000");
+   input += from_hex("01");
+   BOOST_REQUIRE_EQUAL(input.size(), 213);
+
+   BOOST_CHECK(run_precompile(0x09, input) ==
+               from_hex("ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+                        "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923"));
+
+   // Final block indicator must be 0 or 1
+   auto bad_final = input;
+   bad_final[212] = 2;
+   BOOST_CHECK(precompile_fails(0x09, bad_final));
+
+   // Input must be exactly 213 bytes
+   auto short_input = input;
+   short_input.pop_back();
+   BOOST_CHECK(precompile_fails(0x09, short_input));
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(bn_add_and_mul, precompile_evm_tester)
+try {
+   const auto g1 = from_hex(g1_hex);
+
+   auto doubled = run_precompile(0x06, g1 + g1);
+   BOOST_REQUIRE_EQUAL(doubled.size(), 64);
+
+   silkworm::Bytes scalar(32, 0);
+   scalar[31] = 2;
+   BOOST_CHECK(run_precompile(0x07, g1 + scalar) == doubled);
+
+   // G1 + (-G1) is the point at infinity
+   BOOST_CHECK(run_precompile(0x06, g1 + from_hex(neg_g1_hex)) == silkworm::Bytes(64, 0));
+
+   // Short input is zero padded: G1 + 0 == G1
+   BOOST_CHECK(run_precompile(0x06, g1) == g1);
+
+   // (1, 3) is not on the curve
+   auto bad = g1;
+   bad[63] = 3;
+   BOOST_CHECK(precompile_fails(0x06, bad + g1));
+   BOOST_CHECK(precompile_fails(0x07, bad + scalar));
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(bn_pairing, precompile_evm_tester)
+try {
+   const auto g1 = from_hex(g1_hex);
+   const auto neg_g1 = from_hex(neg_g1_hex);
+   const auto g2 = from_hex(g2_hex);
+
+   silkworm::Bytes success(32, 0);
+   success[31] = 1;
+   const silkworm::Bytes failure(32, 0);
+
+   // e(G1, G2) * e(-G1, G2) == 1
+   BOOST_CHECK(run_precompile(0x08, g1 + g2 + neg_g1 + g2) == success);
+   BOOST_CHECK(run_precompile(0x08, g1 + g2 + g1 + g2) == failure);
+
+   // Empty input is a successful check
+   BOOST_CHECK(run_precompile(0x08, {}) == success);
+
+   // Input must be a multiple of 192 bytes
+   BOOST_CHECK(precompile_fails(0x08, g1 + g2 + g1));
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,206 @@
+#include "basic_evm_tester.hpp"
+
+using namespace eosio::testing;
+using namespace evm_test;
+
+struct pushtxs_evm_tester : faucet_evm_tester
+{
+   static constexpr name miner_account_name = "alice"_n;
+
+   pushtxs_evm_tester()
+   {
+      create_accounts({miner_account_name});
+      transfer_token(faucet_account_name, miner_account_name, make_asset(100'0000));
+      open(miner_account_name);
+   }
+
+   // pushtxs is only accepted from version 1 on
+   void enable_pushtxs()
+   {
+      setversion(1, evm_account_name);
+      produce_blocks(2);
+   }
+
+   std::vector<silkworm::Transaction> generate_transfers(const std::vector<evmc::address>& recipients, const intx::uint256& value)
+   {
+      std::vector<silkworm::Transaction> txs;
+      for (const auto& recipient : recipients) {
+         auto tx = generate_tx(recipient, value);
+         faucet_eoa.sign(tx);
+         txs.push_back(std::move(tx));
+      }
+      return txs;
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(pushtxs_evm_tests)
+
+BOOST_FIXTURE_TEST_CASE(pushtxs_requires_version_1, pushtxs_evm_tester)
+try {
+   evm_eoa recipient;
+   auto txs = generate_transfers({recipient.address}, 1_gwei);
+   BOOST_REQUIRE_EXCEPTION(pushtxs(txs, miner_account_name),
+                           eosio_assert_message_exception,
+                           eosio_assert_message_is("pushtxs requires evm_version >= 1"));
+
+   enable_pushtxs();
+   txs = generate_transfers({recipient.address}, 1_gwei);
+   pushtxs(txs, miner_account_name);
+   BOOST_CHECK_EQUAL(*evm_balance(recipient), 1_gwei);
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(pushtxs_executes_all_transactions_in_order, pushtxs_evm_tester)
+try {
+   enable_pushtxs();
+   evm_eoa recipient1;
+   evm_eoa recipient2;
+
+   const intx::uint256 faucet_before = evm_balance(faucet_eoa).value();
+   const intx::uint256 miner_before{vault_balance(miner_account_name)};
+   const intx::uint256 self_before{vault_balance(evm_account_name)};
+
+   auto txs = generate_transfers({recipient1.address, recipient2.address, recipient1.address}, 1_gwei);
+   pushtxs(txs, miner_account_name);
+
+   // From version 1 on the miner only earns the inclusion price, which generate_tx leaves at 0
+   const auto gas_fee = intx::uint256{get_config().gas_price * 21000};
+   const intx::uint256 gas_fee_miner_portion = 0;
+
+   BOOST_CHECK_EQUAL(*evm_balance(recipient1), 2_gwei);
+   BOOST_CHECK_EQUAL(*evm_balance(recipient2), 1_gwei);
+   BOOST_CHECK_EQUAL(*evm_balance(faucet_eoa), faucet_before - 3_gwei - 3 * gas_fee);
+
+   BOOST_CHECK_EQUAL(static_cast<intx::uint256>(vault_balance(miner_account_name)),
+                     miner_before + 3 * gas_fee_miner_portion);
+   BOOST_CHECK_EQUAL(static_cast<intx::uint256>(vault_balance(evm_account_name)),
+                     self_before + 3 * (gas_fee - gas_fee_miner_portion));
+
+   auto faucet_account = find_account_by_address(faucet_eoa.address).value();
+   BOOST_CHECK_EQUAL(faucet_account.nonce, 3);
+
+   check_balances();
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(pushtxs_is_atomic, pushtxs_evm_tester)
+try {
+   enable_pushtxs();
+   evm_eoa recipient;
+
+   const intx::uint256 faucet_before = evm_balance(faucet_eoa).value();
+
+   auto txs = generate_transfers({recipient.address}, 1_gwei);
+
+   // The second transaction spends more than the faucet holds, which must revert the first one as well.
+   auto overspend = generate_tx(recipient.address, faucet_before);
+   faucet_eoa.sign(overspend);
+   txs.push_back(std::move(overspend));
+
+   BOOST_REQUIRE_EXCEPTION(pushtxs(txs, miner_account_name),
+                           eosio_assert_message_exception,
+                           eosio_assert_message_is("validate_transaction error: 23 Insufficient funds"));
+
+   BOOST_CHECK_EQUAL(*evm_balance(faucet_eoa), faucet_before);
+   BOOST_REQUIRE(!evm_balance(recipient).has_value());
+
+   BOOST_REQUIRE_EXCEPTION(pushtxs({}, miner_account_name),
+                           eosio_assert_message_exception,
+                           eosio_assert_message_is("no transactions"));
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(pushtxs_emits_an_event_per_transaction, pushtxs_evm_tester)
+try {
+   enable_pushtxs();
+
+   evm_eoa recipient;
+   auto txs = generate_transfers({recipient.address, recipient.address}, 1_gwei);
+   auto trace = pushtxs(txs, miner_account_name);
+
+   // Without compact events a batch is reported like that many pushtx actions
+   BOOST_REQUIRE(trace->action_traces.size() == 1 + txs.size());
+   BOOST_REQUIRE(trace->action_traces[0].act.name == "pushtxs"_n);
+
+   for (size_t i = 0; i < txs.size(); ++i) {
+      const auto& at = trace->action_traces[1 + i];
+      BOOST_REQUIRE(at.act.name == "evmtx"_n);
+      auto evmtx_v = fc::raw::unpack<evm_test::evmtx_type>(at.act.data.data(), at.act.data.size());
+      BOOST_REQUIRE(std::holds_alternative<evm_test::evmtx_v0>(evmtx_v));
+
+      const auto& event = std::get<evm_test::evmtx_v0>(evmtx_v);
+      BOOST_CHECK_EQUAL(event.eos_evm_version, 1);
+      BOOST_CHECK_EQUAL(event.base_fee_per_gas, get_config().gas_price);
+
+      silkworm::Transaction tx;
+      silkworm::ByteView bv{(const uint8_t*)event.rlptx.data(), event.rlptx.size()};
+      silkworm::rlp::decode(bv, tx);
+      BOOST_REQUIRE(bv.empty());
+      BOOST_CHECK(tx == txs[i]);
+   }
+
+   BOOST_CHECK_EQUAL(*evm_balance(recipient), 2_gwei);
+   check_balances();
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(pushtxs_delivers_bridge_messages_of_every_transaction, pushtxs_evm_tester)
+try {
+   enable_pushtxs();
+
+   create_accounts({"rec1"_n});
+   set_code("rec1"_n, testing::contracts::evm_bridge_receiver_wasm());
+   set_abi("rec1"_n, testing::contracts::evm_bridge_receiver_abi().data());
+   bridgereg("rec1"_n, "rec1"_n, make_asset(0));
+
+   // bridgeMsgV0("rec1", true, "") sent to the reserved address of the contract
+   auto word = [](uint64_t x) {
+      silkworm::Bytes res(32, 0);
+      intx::be::unsafe::store(res.data(), intx::uint256{x});
+      return res;
+   };
+   silkworm::Bytes message = evmc::from_hex("f781185b").value();
+   message += word(96) + word(1) + word(160) + word(4);
+   message += silkworm::Bytes{'r', 'e', 'c', '1'} + silkworm::Bytes(28, 0);
+   message += word(0);
+
+   // The message is not in the last transaction of the batch
+   evm_eoa recipient;
+   auto bridged = generate_tx(make_reserved_address(evm_account_name), 1_ether, 250'000);
+   bridged.data = message;
+   faucet_eoa.sign(bridged);
+   auto transfer = generate_tx(recipient.address, 1_gwei);
+   faucet_eoa.sign(transfer);
+
+   auto trace = pushtxs({bridged, transfer}, miner_account_name);
+   BOOST_CHECK(std::any_of(trace->action_traces.begin(), trace->action_traces.end(),
+                           [](const action_trace& at) { return at.act.name == "onbridgemsg"_n; }));
+   BOOST_CHECK(vault_balance("rec1"_n) == (balance_and_dust{make_asset(1'0000), 0}));
+   BOOST_CHECK_EQUAL(*evm_balance(recipient), 1_gwei);
+   check_balances();
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(large_calldata_rlp_is_not_copied, pushtxs_evm_tester)
+try {
+   evm_eoa recipient;
+
+   auto tx = generate_tx(recipient.address, 1, 2'000'000);
+   tx.data = silkworm::Bytes(32 * 1024, 0x5a);
+   faucet_eoa.sign(tx);
+
+   silkworm::Bytes rlp;
+   silkworm::rlp::encode(rlp, tx);
+   bytes rlp_bytes;
+   rlp_bytes.resize(rlp.size());
+   memcpy(rlp_bytes.data(), rlp.data(), rlp.size());
+
+   // The contract checks the rlp buffer it decodes and releases to the event is the one it was given
+   push_action(evm_account_name, "testrlpmove"_n, evm_account_name, mvo()("rlptx", rlp_bytes));
+
+   pushtx(tx);
+   BOOST_CHECK_EQUAL(*evm_balance(recipient), 1);
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
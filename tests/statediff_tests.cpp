@@ -0,0 +1,216 @@
+#include "basic_evm_tester.hpp"
+
+using namespace eosio::testing;
+using namespace evm_test;
+
+struct statediff_evm_tester : basic_evm_tester
+{
+   static constexpr uint32_t state_diff = 0x2;
+
+   // Runtime code stores 42 in slot 0 and 7 in slot 1, then logs the word 42 with topic 0xaa
+   const std::string store_and_log_bytecode = "6017600c60003960176000f3602a6000556007600155602a60005260aa60206000a100";
+
+   // Runtime code stores 0 in slot 5, which it never wrote before
+   const std::string store_zero_bytecode = "6006600c60003960066000f3600060055500";
+
+   // What an EVM node rebuilds from the statediff events alone
+   struct mirrored_account {
+      uint64_t                                   nonce = 0;
+      intx::uint256                              balance;
+      std::optional<uint64_t>                    code_id;
+      std::map<intx::uint256, intx::uint256>     storage;
+   };
+   std::map<evmc::address, mirrored_account> mirror;
+   std::vector<statediff_v0> diffs;
+
+   evm_eoa faucet_eoa;
+
+   statediff_evm_tester() :
+      faucet_eoa(evmc::from_hex("a3f1b69da92a0233ce29485d3049a4ace39e8d384bbc2557e3fc60940ce4e954").value())
+   {
+      init();
+      setversion(1, evm_account_name);
+      produce_blocks(2);
+      setevents(state_diff);
+   }
+
+   static intx::uint256 from_compact(const bytes& value)
+   {
+      BOOST_REQUIRE(value.size() <= 32);
+      uint8_t buffer[32] = {};
+      memcpy(buffer + 32 - value.size(), value.data(), value.size());
+      return intx::be::load<intx::uint256>(buffer);
+   }
+
+   static evmc::address to_address(const bytes& addr)
+   {
+      BOOST_REQUIRE(addr.size() == sizeof(evmc::address));
+      evmc::address res;
+      memcpy(res.bytes, addr.data(), addr.size());
+      return res;
+   }
+
+   void apply(const transaction_trace_ptr& trace)
+   {
+      for (const auto& at : trace->action_traces) {
+         if (at.act.account != evm_account_name || at.act.name != "statediff"_n) {
+            continue;
+         }
+         auto event = fc::raw::unpack<statediff_type>(at.act.data);
+         const auto& diff = std::get<statediff_v0>(event);
+
+         for (const auto& change : diff.accounts) {
+            const auto address = to_address(change.address);
+            if (!change.nonce) {
+               mirror.erase(address);
+               continue;
+            }
+            auto& account = mirror[address];
+            if (change.fresh) {
+               account = mirrored_account{};
+            }
+            account.nonce = *change.nonce;
+            account.balance = from_compact(change.balance);
+         }
+         for (const auto& change : diff.codes) {
+            mirror[to_address(change.address)].code_id = change.code_id;
+         }
+         for (const auto& change : diff.storage) {
+            const auto address = to_address(change.address);
+            if (change.value.empty()) {
+               if (auto it = mirror.find(address); it != mirror.end()) {
+                  it->second.storage.erase(from_compact(change.key));
+               }
+            } else {
+               mirror[address].storage[from_compact(change.key)] = from_compact(change.value);
+            }
+         }
+         diffs.push_back(diff);
+      }
+   }
+
+   void check_mirror() const
+   {
+      size_t accounts = 0;
+      scan_accounts([&](account_object&& row) -> bool {
+         ++accounts;
+         auto it = mirror.find(row.address);
+         BOOST_REQUIRE_MESSAGE(it != mirror.end(), "account missing from the stream");
+         const auto& account = it->second;
+         BOOST_CHECK_EQUAL(account.nonce, row.nonce);
+         BOOST_CHECK(account.balance == row.balance);
+         BOOST_CHECK(account.code_id == row.code_id);
+
+         std::map<intx::uint256, intx::uint256> storage;
+         scan_account_storage(row.id, [&](storage_slot&& slot) -> bool {
+            storage[slot.key] = slot.value;
+            return false;
+         });
+         BOOST_CHECK(account.storage == storage);
+         return false;
+      });
+      BOOST_CHECK_EQUAL(accounts, mirror.size());
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(statediff_evm_tests)
+
+BOOST_FIXTURE_TEST_CASE(stream_rebuilds_the_tables, statediff_evm_tester)
+try {
+   apply(transfer_token(faucet_account_name, evm_account_name, make_asset(100'0000), faucet_eoa.address_0x()));
+   BOOST_REQUIRE_EQUAL(diffs.size(), 1);
+   BOOST_CHECK_EQUAL(diffs.back().eos_evm_version, 1);
+   BOOST_REQUIRE_EQUAL(diffs.back().txs.size(), 1);
+   BOOST_CHECK(diffs.back().txs[0].success);
+   check_mirror();
+
+   evm_eoa recipient;
+   auto tx = generate_tx(recipient.address, 1_gwei);
+   faucet_eoa.sign(tx);
+   apply(pushtx(tx));
+   BOOST_REQUIRE_EQUAL(diffs.size(), 2);
+   BOOST_REQUIRE_EQUAL(diffs.back().txs.size(), 1);
+   BOOST_CHECK_EQUAL(diffs.back().txs[0].gas_used, 21000);
+   BOOST_CHECK(diffs.back().txs[0].logs.empty());
+   check_mirror();
+
+   // Deploy the contract, then call it to write its slots and emit the log
+   const auto contract_address = silkworm::create_address(faucet_eoa.address, faucet_eoa.next_nonce);
+   silkworm::Transaction deploy{
+      silkworm::UnsignedTransaction {
+         .type = silkworm::TransactionType::kLegacy,
+         .max_priority_fee_per_gas = get_config().gas_price,
+         .max_fee_per_gas = get_config().gas_price,
+         .gas_limit = 1'000'000,
+         .data = evmc::from_hex(store_and_log_bytecode).value(),
+      }
+   };
+   faucet_eoa.sign(deploy);
+   apply(pushtx(deploy));
+   BOOST_REQUIRE(!diffs.back().codes.empty());
+   check_mirror();
+
+   auto call = generate_tx(contract_address, 0, 1'000'000);
+   faucet_eoa.sign(call);
+   apply(pushtx(call));
+   const auto& result = diffs.back().txs.at(0);
+   BOOST_CHECK(result.success);
+   BOOST_REQUIRE_EQUAL(result.logs.size(), 1);
+   BOOST_CHECK(to_address(result.logs[0].address) == contract_address);
+   BOOST_REQUIRE_EQUAL(result.logs[0].topics.size(), 1);
+   BOOST_CHECK(from_compact(result.logs[0].topics[0]) == 0xaa);
+   BOOST_CHECK(from_compact(result.logs[0].data) == 42);
+   check_mirror();
+
+   const auto& stored = mirror.at(contract_address).storage;
+   BOOST_REQUIRE_EQUAL(stored.size(), 2);
+   BOOST_CHECK(stored.at(0) == 42);
+   BOOST_CHECK(stored.at(1) == 7);
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(writes_that_change_nothing_are_left_out, statediff_evm_tester)
+try {
+   apply(transfer_token(faucet_account_name, evm_account_name, make_asset(100'0000), faucet_eoa.address_0x()));
+
+   const auto contract_address = silkworm::create_address(faucet_eoa.address, faucet_eoa.next_nonce);
+   silkworm::Transaction deploy{
+      silkworm::UnsignedTransaction {
+         .type = silkworm::TransactionType::kLegacy,
+         .max_priority_fee_per_gas = get_config().gas_price,
+         .max_fee_per_gas = get_config().gas_price,
+         .gas_limit = 1'000'000,
+         .data = evmc::from_hex(store_zero_bytecode).value(),
+      }
+   };
+   faucet_eoa.sign(deploy);
+   apply(pushtx(deploy));
+
+   // Zero into a slot that is already zero
+   auto call = generate_tx(contract_address, 0, 1'000'000);
+   faucet_eoa.sign(call);
+   apply(pushtx(call));
+   BOOST_REQUIRE_EQUAL(diffs.back().txs.size(), 1);
+   BOOST_CHECK(diffs.back().txs[0].success);
+   BOOST_CHECK(diffs.back().storage.empty());
+   BOOST_CHECK(!diffs.back().accounts.empty());
+
+   check_mirror();
+   BOOST_CHECK(mirror.at(contract_address).storage.empty());
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(stream_is_off_without_the_flag, statediff_evm_tester)
+try {
+   setevents(0);
+
+   auto trace = transfer_token(faucet_account_name, evm_account_name, make_asset(1'0000), faucet_eoa.address_0x());
+   for (const auto& at : trace->action_traces) {
+      BOOST_CHECK(at.act.name != "statediff"_n);
+   }
+   BOOST_CHECK(std::any_of(trace->action_traces.begin(), trace->action_traces.end(),
+                           [](const action_trace& at) { return at.act.name == "evmtx"_n; }));
+}
+FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
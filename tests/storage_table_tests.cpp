@@ -0,0 +1,344 @@
+#include "basic_evm_tester.hpp"
+#include <ethash/keccak.hpp>
+
+using namespace evm_test;
+
+struct table_stats {
+   uint32_t read;
+   uint32_t update;
+   uint32_t create;
+   uint32_t remove;
+   uint32_t cached;
+   uint32_t absent;
+   uint32_t missing;
+};
+FC_REFLECT(table_stats, (read)(update)(create)(remove)(cached)(absent)(missing))
+
+struct db_stats {
+   table_stats account;
+   table_stats storage;
+   uint32_t    coalesced;
+};
+FC_REFLECT(db_stats, (account)(storage)(coalesced))
+
+struct storage_table_tester : basic_evm_tester {
+   // Same Factory/TestContract pair as account_id_tests:
+   //   Factory::deploy(bytes32 salt)   creates TestContract with CREATE2
+   //   TestContract::set_foo(uint val) stores val in slot 0
+   //   TestContract::killme()          self destructs
+   const std::string factory_and_test_bytecode = "608060405234801561001057600080fd5b506102c1806100206000396000f3fe60806040526004361061001e5760003560e01c80632b85ba3814610023575b600080fd5b61003d600480360381019061003891906100d2565b610053565b60405161004a9190610140565b60405180910390f35b6000816040516100629061008a565b8190604051809103906000f5905080158015610082573d6000803e3d6000fd5b509050919050565b6101308061015c83390190565b600080fd5b6000819050919050565b6100af8161009c565b81146100ba57600080fd5b50565b6000813590506100cc816100a6565b92915050565b6000602082840312156100e8576100e7610097565b5b60006100f6848285016100bd565b91505092915050565b600073ffffffffffffffffffffffffffffffffffffffff82169050919050565b600061012a826100ff565b9050919050565b61013a8161011f565b82525050565b60006020820190506101556000830184610131565b9291505056fe608060405234801561001057600080fd5b50610110806100206000396000f3fe6080604052348015600f57600080fd5b506004361060325760003560e01c806324d97a4a146037578063e5d5dfbc14603f575b600080fd5b603d6057565b005b605560048036038101906051919060b2565b6072565b005b60008073ffffffffffffffffffffffffffffffffffffffff16ff5b8060008190555050565b600080fd5b6000819050919050565b6092816081565b8114609c57600080fd5b50565b60008135905060ac81608b565b92915050565b60006020828403121560c55760c4607c565b5b600060d184828501609f565b9150509291505056fea2646970667358221220e59ba0023d9a6f99a6734000d8812c1830a2a61597b322310827ec350a4304dd64736f6c63430008120033a26469706673582212205e94c73549f6e1751509ff5704aec0a8ada3a60ab2b8cc1b9df9febc7ed2bd2f64736f6c63430008120033";
+
+   evm_eoa evm1;
+
+   storage_table_tester() {
+      create_accounts({"alice"_n});
+      transfer_token(faucet_account_name, "alice"_n, make_asset(10000'0000));
+      init();
+   }
+
+   void call_contract(const evmc::address& to, const silkworm::Bytes& data) {
+      auto txn = generate_tx(to, 0, 1'000'000);
+      txn.data = data;
+      evm1.sign(txn);
+      pushtx(txn);
+   }
+
+   void factory_deploy(const evmc::address& factory, uint64_t salt) {
+      silkworm::Bytes data;
+      data += evmc::from_hex("2b85ba38").value(); // deploy
+      data += evmc::bytes32{salt};
+      call_contract(factory, data);
+   }
+
+   void set_foo(const evmc::address& test_contract, uint64_t val) {
+      silkworm::Bytes data;
+      data += evmc::from_hex("e5d5dfbc").value(); // set_foo
+      data += evmc::bytes32{val};
+      call_contract(test_contract, data);
+   }
+
+   void killme(const evmc::address& test_contract) {
+      call_contract(test_contract, evmc::from_hex("24d97a4a").value());
+   }
+
+   // Same id as the one derived by the contract
+   static uint64_t slot_id(const intx::uint256& location) {
+      const auto key = intx::be::store<evmc::bytes32>(location);
+      const auto hash = ethash::keccak256(key.bytes, sizeof(key.bytes));
+      return intx::be::unsafe::load<uint64_t>(hash.bytes);
+   }
+
+   int64_t ram_usage() const {
+      return control->get_resource_limits_manager().get_account_ram_usage(evm_account_name);
+   }
+
+   // Raw `storage2` rows by id, including the zero valued ones
+   std::map<uint64_t, intx::uint256> storage2_rows(uint64_t account_id) const {
+      std::map<uint64_t, intx::uint256> res;
+      scan_table<storage2_table_row>("storage2"_n, name{account_id}, [&](storage2_table_row&& row) {
+         res[row.id] = row.get_value();
+         return false;
+      });
+      return res;
+   }
+
+   db_stats teststate(const evmc::address& address, const std::vector<intx::uint256>& locations, const intx::uint256& value, bool warm = false) {
+      std::vector<bytes> locs;
+      for (const auto& location : locations) {
+         locs.push_back(to_bytes(location));
+      }
+      auto trace = push_action(evm_account_name, "teststate"_n, evm_account_name,
+         mvo()("addy", to_bytes(address))("locations", locs)("value", to_bytes(value))("warm", warm));
+      return fc::raw::unpack<db_stats>(trace->action_traces[0].return_value);
+   }
+
+   size_t legacy_storage_rows(uint64_t account_id) const {
+      size_t total = 0;
+      scan_table<storage_table_row>("storage"_n, name{account_id}, [&](storage_table_row&&) {
+         ++total;
+         return false;
+      });
+      return total;
+   }
+
+   std::map<intx::uint256, intx::uint256> slots(uint64_t account_id) const {
+      std::map<intx::uint256, intx::uint256> res;
+      BOOST_REQUIRE(scan_account_storage(account_id, [&](storage_slot&& slot) -> bool {
+         BOOST_REQUIRE(res.count(slot.key) == 0);
+         res[slot.key] = slot.value;
+         return false;
+      }));
+      return res;
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(storage_table_tests)
+
+BOOST_FIXTURE_TEST_CASE(slots_are_keyed_by_location, storage_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   auto factory = deploy_contract(evm1, evmc::from_hex(factory_and_test_bytecode).value());
+   factory_deploy(factory, 555);
+   const auto test_contract = find_account_by_id(2).value();
+
+   set_foo(test_contract.address, 1234);
+   BOOST_REQUIRE(storage2_rows(test_contract.id) == (std::map<uint64_t, intx::uint256>{{slot_id(0), 1234}}));
+
+   const intx::uint256 loc1 = 1;
+   const intx::uint256 loc2 = intx::uint256{1} << 192;
+   setkvstore(test_contract.id, to_bytes(loc1), to_bytes(intx::uint256(11)));
+   setkvstore(test_contract.id, to_bytes(loc2), to_bytes(intx::uint256(22)));
+   BOOST_REQUIRE(storage2_rows(test_contract.id) == (std::map<uint64_t, intx::uint256>{{slot_id(0), 1234}, {slot_id(loc1), 11}, {slot_id(loc2), 22}}));
+   BOOST_REQUIRE(slots(test_contract.id) == (std::map<intx::uint256, intx::uint256>{{0, 1234}, {loc1, 11}, {loc2, 22}}));
+
+   setkvstore(test_contract.id, to_bytes(loc2), to_bytes(intx::uint256(23)));
+   BOOST_REQUIRE(storage2_rows(test_contract.id).at(slot_id(loc2)) == 23);
+
+   // Without a collision, removing a slot drops its row
+   setkvstore(test_contract.id, to_bytes(loc1), {});
+   BOOST_REQUIRE(storage2_rows(test_contract.id) == (std::map<uint64_t, intx::uint256>{{slot_id(0), 1234}, {slot_id(loc2), 23}}));
+   BOOST_REQUIRE_EXCEPTION(setkvstore(test_contract.id, to_bytes(loc1), {}),
+      eosio_assert_message_exception, eosio_assert_message_is("key not found"));
+
+   setkvstore(test_contract.id, to_bytes(loc2), {});
+   BOOST_REQUIRE(storage2_rows(test_contract.id) == (std::map<uint64_t, intx::uint256>{{slot_id(0), 1234}}));
+
+   // The contract still sees its own slot
+   set_foo(test_contract.address, 0);
+   BOOST_REQUIRE(storage2_rows(test_contract.id).empty());
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(legacy_storage_is_migrated, storage_table_tester) try {
+
+   // Populate the legacy `storage` table with the old contract
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm_0_5_1());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi_0_5_1().data());
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   auto factory = deploy_contract(evm1, evmc::from_hex(factory_and_test_bytecode).value());
+   factory_deploy(factory, 555);
+   factory_deploy(factory, 556);
+   const auto test1 = find_account_by_id(2).value();
+   const auto test2 = find_account_by_id(3).value();
+   set_foo(test1.address, 1234);
+   set_foo(test2.address, 5678);
+
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi().data());
+
+   BOOST_REQUIRE_EQUAL(legacy_storage_rows(test1.id), 1);
+   BOOST_REQUIRE_EQUAL(legacy_storage_rows(test2.id), 1);
+   BOOST_REQUIRE(slots(test1.id) == (std::map<intx::uint256, intx::uint256>{{0, 1234}}));
+
+   // Writing a slot moves it
+   set_foo(test1.address, 4321);
+   BOOST_CHECK_EQUAL(legacy_storage_rows(test1.id), 0);
+   BOOST_CHECK(storage2_rows(test1.id) == (std::map<uint64_t, intx::uint256>{{0, 4321}}));
+
+   BOOST_REQUIRE_EXCEPTION(migratestor(10, "alice"_n),
+      missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+   // The rest is migrated by the action, resuming where the previous call stopped
+   auto trace = migratestor(1);
+   produce_block();
+   BOOST_CHECK(!fc::raw::unpack<bool>(trace->action_traces[0].return_value));
+   trace = migratestor(10);
+   BOOST_CHECK(fc::raw::unpack<bool>(trace->action_traces[0].return_value));
+
+   BOOST_CHECK_EQUAL(legacy_storage_rows(test2.id), 0);
+   BOOST_CHECK(slots(test2.id) == (std::map<intx::uint256, intx::uint256>{{0, 5678}}));
+
+   // Migrated slots are collected with the account
+   killme(test2.address);
+   gc(10);
+   BOOST_CHECK(storage2_rows(test2.id).empty());
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(writes_reuse_lookups_of_reads, storage_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   const auto account_id = find_account_by_address(evm1.address)->id;
+
+   // Each row is looked up once, the writes that follow the reads go straight to it
+   auto stats = teststate(evm1.address, {7}, 42);
+   BOOST_CHECK_EQUAL(stats.account.read, 1);
+   BOOST_CHECK_EQUAL(stats.account.cached, 2);
+   BOOST_CHECK_EQUAL(stats.account.update, 1);
+   BOOST_CHECK_EQUAL(stats.storage.read, 1);
+   BOOST_CHECK_EQUAL(stats.storage.missing, 1);
+   BOOST_CHECK_EQUAL(stats.storage.absent, 1);
+   BOOST_CHECK_EQUAL(stats.storage.cached, 1);
+   BOOST_CHECK_EQUAL(stats.storage.create, 1);
+
+   stats = teststate(evm1.address, {7}, 43);
+   BOOST_CHECK_EQUAL(stats.storage.read, 1);
+   BOOST_CHECK_EQUAL(stats.storage.cached, 2);
+   BOOST_CHECK_EQUAL(stats.storage.update, 1);
+
+   stats = teststate(evm1.address, {7}, 0);
+   BOOST_CHECK_EQUAL(stats.storage.read, 1);
+   BOOST_CHECK_EQUAL(stats.storage.cached, 2);
+   BOOST_CHECK_EQUAL(stats.storage.remove, 1);
+   BOOST_CHECK(storage2_rows(account_id).empty());
+   BOOST_CHECK_EQUAL(find_account_by_address(evm1.address)->nonce, 3);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(writes_are_buffered_and_coalesced, storage_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   const auto account_id = find_account_by_address(evm1.address)->id;
+
+   // The last read of slot 1 sees the buffered write, the second write replaces it
+   auto stats = teststate(evm1.address, {3, 1, 2, 1}, 42);
+   BOOST_CHECK_EQUAL(stats.storage.read, 3);
+   BOOST_CHECK_EQUAL(stats.storage.cached, 4);
+   BOOST_CHECK_EQUAL(stats.storage.absent, 4);
+   BOOST_CHECK_EQUAL(stats.storage.create, 3);
+   BOOST_CHECK_EQUAL(stats.coalesced, 1);
+   BOOST_CHECK(storage2_rows(account_id) == (std::map<uint64_t, intx::uint256>{{1, 42}, {2, 42}, {3, 42}}));
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(missing_rows_are_looked_up_once, storage_table_tester) try {
+
+   evm_eoa evm2;
+   auto stats = teststate(evm2.address, {5}, 0);
+   BOOST_CHECK_EQUAL(stats.account.read, 1);
+   BOOST_CHECK_EQUAL(stats.account.missing, 1);
+   BOOST_CHECK_EQUAL(stats.account.absent, 3);
+   BOOST_CHECK_EQUAL(stats.storage.read, 0);
+   BOOST_CHECK(!find_account_by_address(evm2.address));
+
+   // Once written the account is found again
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm2.address_0x());
+   stats = teststate(evm2.address, {5}, 0);
+   BOOST_CHECK_EQUAL(stats.account.missing, 0);
+   BOOST_CHECK_EQUAL(stats.account.update, 1);
+   BOOST_CHECK_EQUAL(stats.storage.missing, 1);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(access_lists_warm_up_rows, storage_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   teststate(evm1.address, {1}, 11);
+
+   // The rows of the access list are read up front, execution only hits the caches
+   auto stats = teststate(evm1.address, {2, 1}, 12, true);
+   BOOST_CHECK_EQUAL(stats.account.read, 1);
+   BOOST_CHECK_EQUAL(stats.storage.read, 2);
+   BOOST_CHECK_EQUAL(stats.storage.missing, 1);
+   BOOST_CHECK_EQUAL(stats.storage.absent, 2);
+   BOOST_CHECK_EQUAL(stats.storage.cached, 4);
+   BOOST_CHECK_EQUAL(stats.storage.update, 1);
+   BOOST_CHECK_EQUAL(stats.storage.create, 1);
+
+   // Accounts missing from the state are remembered as such
+   evm_eoa evm2;
+   stats = teststate(evm2.address, {1}, 0, true);
+   BOOST_CHECK_EQUAL(stats.account.missing, 1);
+   BOOST_CHECK_EQUAL(stats.storage.read, 0);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(small_slots_take_less_ram, storage_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   const auto account_id = find_account_by_address(evm1.address)->id;
+   // the first row also creates the table of the scope
+   setkvstore(account_id, to_bytes(intx::uint256(0)), to_bytes(intx::uint256(1)));
+
+   const auto ram_per_slot = [&](const intx::uint256& base, const intx::uint256& value) {
+      constexpr int64_t slots = 10;
+      const auto before = ram_usage();
+      for (int64_t i = 1; i <= slots; ++i) {
+         setkvstore(account_id, to_bytes(base + i), to_bytes(value));
+      }
+      return (ram_usage() - before) / slots;
+   };
+
+   const intx::uint256 high = intx::uint256(1) << 255;
+   const auto small = ram_per_slot(0, 1);
+   const auto large = ram_per_slot(high, high + 1);
+   BOOST_TEST_MESSAGE("ram per slot: small=" << small << " large=" << large);
+
+   // Only the leading zero bytes of keys and values are saved
+   BOOST_CHECK_EQUAL(large - small, 2 * 31);
+   BOOST_CHECK_EQUAL(storage2_rows(account_id).at(slot_id(1)), 1);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(crafted_slots_do_not_chain, storage_table_tester) try {
+
+   transfer_token("alice"_n, evm_account_name, make_asset(1000000), evm1.address_0x());
+   const auto account_id = find_account_by_address(evm1.address)->id;
+
+   // Each of these folds to the same 64 bit word when the words of the slot are xor-ed
+   const intx::uint256 x = 0x1234567890abcdefull;
+   const intx::uint256 y = 0x1111111111111111ull;
+   const intx::uint256 z = 0x2222222222222222ull;
+   const std::vector<intx::uint256> locations = {
+      (x << 192) | x,
+      (x << 128) | (x << 64),
+      (y << 192) | (y << 128) | (z << 64) | z,
+      0,
+   };
+
+   std::map<uint64_t, intx::uint256> expected;
+   for (size_t i = 0; i < locations.size(); ++i) {
+      setkvstore(account_id, to_bytes(locations[i]), to_bytes(intx::uint256(i + 1)));
+      expected[slot_id(locations[i])] = i + 1;
+   }
+
+   // Every slot sits at its own home id, none of them was probed past it
+   BOOST_CHECK(storage2_rows(account_id) == expected);
+   BOOST_CHECK(std::all_of(expected.begin(), expected.end(), [&](const auto& row) {
+      return !expected.count(row.first + 1);
+   }));
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
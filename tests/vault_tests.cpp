@@ -0,0 +1,153 @@
+#include "basic_evm_tester.hpp"
+
+using namespace evm_test;
+using eosio::testing::eosio_assert_message_is;
+
+struct legacy_balance_row {
+   name owner;
+   asset balance;
+   uint64_t dust = 0;
+};
+FC_REFLECT(legacy_balance_row, (owner)(balance)(dust))
+
+struct legacy_nonce_row {
+   name owner;
+   uint64_t next_nonce = 0;
+};
+FC_REFLECT(legacy_nonce_row, (owner)(next_nonce))
+
+struct vault_tester : basic_evm_tester {
+   vault_tester() {
+      create_accounts({"alice"_n, "bob"_n});
+      transfer_token(faucet_account_name, "alice"_n, make_asset(10000'0000));
+      transfer_token(faucet_account_name, "bob"_n, make_asset(10000'0000));
+      init();
+   }
+
+   std::map<name, vault_table_row> vault_rows() const {
+      std::map<name, vault_table_row> res;
+      scan_table<vault_table_row>("vaults"_n, evm_account_name, [&](vault_table_row&& row) {
+         res[row.owner] = row;
+         return false;
+      });
+      return res;
+   }
+
+   name vault_payer(name owner) const {
+      const auto& db = control->db();
+      const auto* t_id = db.find<chain::table_id_object, chain::by_code_scope_table>(
+         boost::make_tuple(evm_account_name, evm_account_name, "vaults"_n));
+      BOOST_REQUIRE(t_id);
+      const auto* row = db.find<chain::key_value_object, chain::by_scope_primary>(
+         boost::make_tuple(t_id->id, owner.to_uint64_t()));
+      BOOST_REQUIRE(row);
+      return row->payer;
+   }
+
+   template <typename Row>
+   size_t legacy_rows(name table) const {
+      size_t total = 0;
+      scan_table<Row>(table, evm_account_name, [&](Row&&) {
+         ++total;
+         return false;
+      });
+      return total;
+   }
+
+   // Zero valued EOS->EVM call of `from`, which uses its next nonce
+   void call_eoa(name from) {
+      evm_eoa recipient;
+      auto to = evmc::bytes{std::begin(recipient.address.bytes), std::end(recipient.address.bytes)};
+      silkworm::Bytes data;
+      call(from, to, silkworm::Bytes(evmc::bytes32{}), data, 21000, from);
+   }
+};
+
+BOOST_AUTO_TEST_SUITE(vault_tests)
+
+BOOST_FIXTURE_TEST_CASE(open_accounts_have_a_single_row, vault_tester) try {
+
+   open("alice"_n);
+   open("bob"_n);
+   BOOST_REQUIRE_EQUAL(vault_rows().size(), 3);
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_balance_row>("balances"_n), 0);
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_nonce_row>("nextnonces"_n), 0);
+
+   // Balance and nonce of a call are taken from the same row
+   transfer_token("alice"_n, evm_account_name, make_asset(1'0000), "alice");
+   call_eoa("alice"_n);
+   assertnonce("alice"_n, 1);
+   BOOST_CHECK_EQUAL(vault_rows().at("alice"_n).next_nonce, 1);
+   BOOST_CHECK(vault_balance("alice"_n).balance < make_asset(1'0000));
+
+   // A closed account keeps its row while its nonce has been used
+   addopenbal("alice"_n, intx::uint256(vault_balance("alice"_n)), true);
+   close("alice"_n);
+   BOOST_CHECK(!vault_rows().at("alice"_n).open);
+   BOOST_REQUIRE_EXCEPTION(withdraw("alice"_n, make_asset(1)),
+      eosio_assert_message_exception, eosio_assert_message_is("account is not open"));
+   assertnonce("alice"_n, 1);
+
+   open("alice"_n);
+   BOOST_CHECK(vault_rows().at("alice"_n).open);
+   BOOST_CHECK_EQUAL(vault_balance("alice"_n).balance, make_asset(0));
+   assertnonce("alice"_n, 1);
+
+   close("bob"_n);
+   BOOST_CHECK(!vault_rows().count("bob"_n));
+   assertnonce("bob"_n, 0);
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_FIXTURE_TEST_CASE(legacy_rows_are_merged, vault_tester) try {
+
+   // Populate the legacy `balances` and `nextnonces` tables with the old contract
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm_0_5_1());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi_0_5_1().data());
+
+   create_accounts({"carol"_n});
+   open("alice"_n);
+   open("bob"_n);
+   open("carol"_n);
+   transfer_token("alice"_n, evm_account_name, make_asset(1'0000), "alice");
+
+   set_code(evm_account_name, testing::contracts::evm_runtime_wasm());
+   set_abi(evm_account_name, testing::contracts::evm_runtime_abi().data());
+
+   BOOST_REQUIRE_EQUAL(legacy_rows<legacy_balance_row>("balances"_n), 3);
+   BOOST_REQUIRE_EQUAL(legacy_rows<legacy_nonce_row>("nextnonces"_n), 3);
+   BOOST_CHECK_EQUAL(vault_balance("alice"_n).balance, make_asset(1'0000));
+
+   // Using an account moves both of its rows
+   transfer_token("alice"_n, evm_account_name, make_asset(1'0000), "alice");
+   BOOST_CHECK_EQUAL(vault_rows().at("alice"_n).balance, make_asset(2'0000));
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_balance_row>("balances"_n), 2);
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_nonce_row>("nextnonces"_n), 2);
+   assertnonce("bob"_n, 0);
+
+   // RAM can't be billed to alice in a notification, the contract pays for her row
+   BOOST_CHECK_EQUAL(vault_payer("alice"_n), evm_account_name);
+
+   // bob authorizes the action that merges his rows, so he keeps paying for them
+   open("bob"_n);
+   BOOST_CHECK_EQUAL(vault_payer("bob"_n), "bob"_n);
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_balance_row>("balances"_n), 1);
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_nonce_row>("nextnonces"_n), 1);
+
+   BOOST_REQUIRE_EXCEPTION(migratevault(10, "alice"_n),
+      missing_auth_exception, eosio::testing::fc_exception_message_starts_with("missing authority"));
+
+   auto trace = migratevault(10);
+   BOOST_CHECK(fc::raw::unpack<bool>(trace->action_traces[0].return_value));
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_balance_row>("balances"_n), 0);
+   BOOST_CHECK_EQUAL(legacy_rows<legacy_nonce_row>("nextnonces"_n), 0);
+   BOOST_CHECK(vault_rows().at("carol"_n).open);
+   BOOST_CHECK_EQUAL(vault_payer("carol"_n), evm_account_name);
+
+   close("bob"_n);
+   close("carol"_n);
+   check_balances();
+
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()